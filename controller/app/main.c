@@ -1,7 +1,26 @@
 #include <msp430.h>
 #include "../src/keypad.h"
 #include "../src/i2c_master.h"
+#include "../src/i2c_bus.h"
 #include "../src/lcd.h"
+#include "../src/params.h"
+#include "../src/param_edit.h"
+#include "../src/rotary.h"
+#include "../src/fmt.h"
+#include "../src/clock.h"
+#include "../src/black_scholes.h"
+#include "../src/persist.h"
+#include "../src/pricer.h"
+#include "../src/cmd.h"
+#include "../src/ledbar_ctl.h"
+#include "../src/chain.h"
+#include "../src/binomial.h"
+#include "../src/watchlist.h"
+#include "../src/stats.h"
+#include "../src/volsurf.h"
+#include "../src/scenario.h"
+#include "../src/trace.h"
+#include "../src/uart.h"
 #include <string.h>
 #include <stdint.h>
 #include <math.h>
@@ -11,18 +30,13 @@
 #define STATE_INPUT_PARAM 2
 #define STATE_DISPLAY_RESULT 3
 
-// Parameter IDs
-#define PARAM_STOCK_PRICE 1
-#define PARAM_STRIKE_PRICE 2
-#define PARAM_TIME_EXP     3
-#define PARAM_VOLATILITY   4
-#define PARAM_RISK_FREE    5
-#define PARAM_MKT_PRICE    6
-
-// Encoder step sizes
-#define NUM_STEPS 4
-const float step_values[NUM_STEPS] = {10.0f, 1.0f, 0.1f, 0.01f};
+// Labels for step_values
 const char *step_labels[NUM_STEPS] = {"x10"," x1","0.1","0.01"};
+
+// Chain strike spacings, cycled with '*' on the chain screen
+#define NUM_SPACINGS 4
+const float chain_spacings[NUM_SPACINGS] = {1.0f, 2.5f, 5.0f, 10.0f};
+volatile int spacing_idx = 2;
 volatile int step_idx = 1;
 volatile float encoder_step = 1.0f;
 volatile float edit_value = 0.0f;
@@ -33,18 +47,18 @@ char keypad_input[6] = {0};  // buffer for user input
 volatile int input_index = 0;
 volatile int send_i2c_update_flag = 0;
 
-volatile float stock_price = 85.43f;
-volatile float strike_price = 105.0f;
-volatile float time_to_exp = 0.12f;
-volatile float volatility = 0.45f;
-volatile float risk_free_rate = 0.05f;
-volatile float market_price = 0.65f;
-
-float norm_cdf(float x);
-float black_scholes_call(float S, float K, float T, float r, float sigma);
 void display_prompt_param(int param);
-void display_result(float result);
+void display_result(const struct bs_result *res, float market_price);
+void show_result_until_key(void);
+void show_chain_until_key(void);
+void show_american_until_key(void);
+void show_watch_until_key(void);
+void show_stats_until_key(void);
+void show_smile_until_key(void);
+void show_scenario_until_key(void);
 void process_keypad(void);
+void show_main_menu(void);
+void show_edit_value(void);
 
 
 
@@ -68,15 +82,14 @@ void setup_heartbeat() {
     // -- Timer B0 --
     TB0R = 0;
     TB0CCTL0 = CCIE;                                                    // Enable Interrupt
-    TB0CCR0 = 32820;                                                    // 1 sec timer
-    TB0EX0 = TBIDEX__8;                                                 // D8
-    TB0CTL = TBSSEL__SMCLK | MC__UP | ID__4;                            // Small clock, Up counter,  D4
+    TB0CCR0 = ACLK_HZ - 1;                                              // 1 sec timer
+    TB0CTL = TBSSEL__ACLK | MC__UP;                                     // ACLK, Up counter
     TB0CCTL0 &= ~CCIFG;
 }  
 
 void setup_ledbar_update_timer() {
     TB1CTL = TBSSEL__ACLK | MC__UP | ID__4;                             // Use ACLK, up mode, divider 4
-    TB1CCR0 = (int)((32000 * base_tp) / 4.0);                           // Set update interval based on base_tp
+    TB1CCR0 = (int)((ACLK_HZ * base_tp) / 4.0);                         // Set update interval based on base_tp
     TB1CCTL0 = CCIE;                                                    // Enable interrupt for TB1 CCR0
 } 
 
@@ -117,36 +130,42 @@ void change_led_pattern(int new_pattern) {
 
 void update_slave_ledbar() {
     volatile int ledbar_pattern = compute_ledbar();
-    while(i2c_busy);
     i2c_write_led(ledbar_pattern);
 }
 
 void process_keypad() {
     
     char key = pressed_key();
+    struct option_params p;
 
     if (key == '\0') return;
+    TRACE(TRACE_EV_KEY, key);
          switch (state_variable) {
             case STATE_MODE_SELECT:
             // --------------------------------------------
             // ------------ MODE SELECT -------------------
             // --------------------------------------------
-                if (key >= '1' && key <= '6') {
+                if (key >= '1' && key <= '0' + PARAM_COUNT) {
                     current_param = key - '0';
-                    // Initialize edit_value
-                    switch (current_param) {
-                        case PARAM_STOCK_PRICE:  edit_value = stock_price;    break;
-                        case PARAM_STRIKE_PRICE: edit_value = strike_price;   break;
-                        case PARAM_TIME_EXP:     edit_value = time_to_exp;    break;
-                        case PARAM_VOLATILITY:   edit_value = volatility;     break;
-                        case PARAM_RISK_FREE:    edit_value = risk_free_rate; break;
-                        case PARAM_MKT_PRICE:    edit_value = market_price;   break;
-                    }
+                    edit_value = params_get(current_param);    // Initialize edit_value
                     display_prompt_param(current_param);
                     show_edit_value();
                     state_variable = STATE_INPUT_PARAM;
                 } else if (key == '#') {
                     state_variable = STATE_DISPLAY_RESULT;
+                } else if (key == 'A') {
+                    show_chain_until_key();
+                } else if (key == 'B') {
+                    show_american_until_key();
+                } else if (key == 'D') {
+                    show_watch_until_key();
+                } else if (key == '0') {
+                    show_stats_until_key();
+                } else if (key == '9') {
+                    volsurf_set_smile(!volsurf_smile());
+                    show_smile_until_key();
+                } else if (key == '8') {
+                    show_scenario_until_key();
                 }
             break;
                 // Show step label  
@@ -162,16 +181,10 @@ void process_keypad() {
                     }
 
                 if (key == 'C') {
-                    // Store confirmed value
-                    switch (current_param) {
-                        case PARAM_STOCK_PRICE:  stock_price    = edit_value; break;
-                        case PARAM_STRIKE_PRICE: strike_price   = edit_value; break;
-                        case PARAM_TIME_EXP:     time_to_exp    = edit_value; break;
-                        case PARAM_VOLATILITY:   volatility     = edit_value; break;
-                        case PARAM_RISK_FREE:    risk_free_rate = edit_value; break;
-                        case PARAM_MKT_PRICE:    market_price = edit_value;   break;
-                        default: break;
-                    }
+                    params_set(current_param, edit_value);      // Store confirmed value
+                    reprice(&p);
+                    params_snapshot(&p);    // reprice() put the smile's vol in p
+                    persist_save(&p, &last_result, volsurf_smile());
                     show_main_menu();
                     state_variable = STATE_MODE_SELECT;
                     
@@ -183,112 +196,421 @@ void process_keypad() {
             
 
          case STATE_DISPLAY_RESULT: 
-            __disable_interrupt();
-             float result = black_scholes_call(
-                stock_price, strike_price,
-                time_to_exp, risk_free_rate,
-                volatility
-            ); 
-            // compute percent difference vs market price
-            float pct_diff = 0.0f;
-            if (result != 0.0f) {
-                pct_diff = (market_price - result) / result * 100.0f;
-            }
-            
-            __enable_interrupt();
+            show_result_until_key();
+        break;
 
-            lcd_clear();
+    }
+}
+
+void display_result(const struct bs_result *res, float market_price) {
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+
+    lcd_clear();
             
-            // format result xx.xx
-            int pr = (int)(result * 100 + 0.5f);
-            int w = pr / 100;
-            int f = pr % 100;
-            char res_str[8]; int idr = 0;
-            if (w >= 100) {
-                res_str[idr++] = '0' + (w / 100);
-                res_str[idr++] = '0' + ((w / 10) % 10);
-                res_str[idr++] = '0' + (w % 10);
-            } else if (w >= 10) {
-                res_str[idr++] = '0' + (w / 10);
-                res_str[idr++] = '0' + (w % 10);
-            } else {
-                res_str[idr++] = '0';
-                res_str[idr++] = '0' + w;
-            }
-            res_str[idr++] = '.';
-            res_str[idr++] = '0' + (f / 10);
-            res_str[idr++] = '0' + (f % 10);
-            res_str[idr] = '\0';
-            // format market price xx.xx
-            int mp = (int)(market_price * 100 + 0.5f);
-            int mw = mp / 100;
-            int mf = mp % 100;
-            char mkt_str[8]; int idm = 0;
-            if (mw >= 100) {
-                mkt_str[idm++] = '0' + (mw / 100);
-                mkt_str[idm++] = '0' + ((mw / 10) % 10);
-                mkt_str[idm++] = '0' + (mw % 10);
-            } else if (mw >= 10) {
-                mkt_str[idm++] = '0' + (mw / 10);
-                mkt_str[idm++] = '0' + (mw % 10);
-            } else {
-                mkt_str[idm++] = '0';
-                mkt_str[idm++] = '0' + mw;
-            }
-            mkt_str[idm++] = '.';
-            mkt_str[idm++] = '0' + (mf / 10);
-            mkt_str[idm++] = '0' + (mf % 10);
-            mkt_str[idm] = '\0';
-            // format percent diff with one decimal and % sign
-            char pct_str[8]; int idp = 0;
-            // sign
-            pct_str[idp++] = (pct_diff >= 0.0f) ? '+' : '-';
-            int pd = (int)(fabsf(pct_diff) * 10 + 0.5f); // one decimal
-            int pd_w = pd / 10;
-            int pd_f = pd % 10;
-            if (pd_w >= 100) {
-                pct_str[idp++] = '0' + (pd_w / 100);
-                pct_str[idp++] = '0' + ((pd_w / 10) % 10);
-                pct_str[idp++] = '0' + (pd_w % 10);
-            } else if (pd_w >= 10) {
-                pct_str[idp++] = '0' + (pd_w / 10);
-                pct_str[idp++] = '0' + (pd_w % 10);
+    // first line: Call and put, second line: Market price and % diff
+    n = 0;
+    memcpy(line, "C:", 2);     n += 2;
+    n += fmt_float(&line[n], res->call, 2, 5, FMT_ZERO);
+    memcpy(&line[n], " P:", 3); n += 3;
+    n += fmt_float(&line[n], res->put, 2, 5, FMT_ZERO);
+    lcd_set_cursor(0, 0);
+    lcd_puts(line);
+
+    n = 0;
+    memcpy(line, "Mkt:", 4);   n += 4;
+    n += fmt_float(&line[n], market_price, 2, 5, FMT_ZERO);
+    line[n++] = ' ';
+    n += fmt_float(&line[n], res->pct_diff, 1, 5, FMT_PLUS | FMT_ZERO);
+    line[n++] = '%';
+    line[n] = '\0';
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+}
+
+void show_result_until_key(void) {
+    struct option_params p;
+    struct bs_result shown;
+    reprice(&p);
+    shown = last_result;            // The LCD waits serve the UART, which reprices
+    display_result(&shown, p.market_price);
+    while (!pressed_key()) {
+        cmd_poll();                 // Keep serving quotes while the result is shown
+        watch_idle();
+        set_ledbar_percent(last_result.pct_diff);
+    }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
+}
+
+void display_chain_row(const struct chain *c, int idx, float market_price) {
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+
+    lcd_clear();
+
+    // first line: strike and call, second line: position and market price
+    n = 0;
+    line[n++] = 'K';
+    n += fmt_float(&line[n], c->strike[idx], 2, 6, 0);
+    memcpy(&line[n], " C", 2); n += 2;
+    n += fmt_float(&line[n], c->call[idx], 2, 5, FMT_ZERO);
+    lcd_set_cursor(0, 0);
+    lcd_puts(line);
+
+    n = 0;
+    n += fmt_fixed(&line[n], idx + 1, 0, 1, 0);
+    line[n++] = '/';
+    n += fmt_fixed(&line[n], c->count, 0, 1, 0);
+    memcpy(&line[n], " Mkt:", 5); n += 5;
+    n += fmt_float(&line[n], market_price, 2, 5, FMT_ZERO);
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+}
+
+/**
+ * Price the strip around the current strike and browse it: the encoder
+ * scrolls strikes, '*' cycles the spacing, '#' the number of strikes (3 to
+ * CHAIN_MAX), any other key returns to the menu. The LED bar marks where
+ * the market price sits in the strip.
+ */
+void show_chain_until_key(void) {
+    struct option_params p;
+    struct chain c;
+    int idx;
+    char key;
+
+    params_snapshot(&p);
+    chain_set_spacing(chain_spacings[spacing_idx]);
+    TRACE(TRACE_EV_PRICE_START, 1);
+    chain_price(&c, &p);
+    TRACE(TRACE_EV_PRICE_END, 1);
+    idx = c.count / 2;
+    encoder_get_delta();                    // Drop movement from before the screen
+    display_chain_row(&c, idx, p.market_price);
+
+    while (1) {
+        cmd_poll();
+        set_ledbar_mask(chain_market_mask(&c, p.market_price));
+
+        int16_t delta = encoder_get_delta();
+        if (delta) {
+            idx += delta;
+            if (idx < 0) idx = 0;
+            if (idx >= c.count) idx = c.count - 1;
+            display_chain_row(&c, idx, p.market_price);
+        }
+
+        key = pressed_key();
+        if (key == '*' || key == '#') {
+            if (key == '*') {
+                spacing_idx = (spacing_idx + 1) % NUM_SPACINGS;
+                chain_set_spacing(chain_spacings[spacing_idx]);
             } else {
-                pct_str[idp++] = '0';
-                pct_str[idp++] = '0' + pd_w;
+                chain_set_count(chain_get_count() >= CHAIN_MAX ? 3 : chain_get_count() + 2);
             }
-            pct_str[idp++] = '.';
-            pct_str[idp++] = '0' + pd_f;
-            pct_str[idp++] = '%';
-            pct_str[idp] = '\0';
-
-            // display first line: Call price
-            lcd_set_cursor(0, 0);
-            lcd_puts("Call:");
-            lcd_puts(res_str);
-            
-            // display second line: Market price and % diff
-            lcd_set_cursor(1, 0);
-            lcd_puts("Mkt:");
-            lcd_puts(mkt_str);
-            lcd_puts(" ");
-            lcd_puts(pct_str);
-            
-            while (!pressed_key()) {
-                set_ledbar_percent(pct_diff);
-            }
-            show_main_menu();
-            state_variable = STATE_MODE_SELECT;
-        break;
+            chain_price(&c, &p);
+            if (idx >= c.count) idx = c.count - 1;
+            display_chain_row(&c, idx, p.market_price);
+        } else if (key) {
+            break;
+        }
+    }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
+}
+
+void show_american_until_key(void) {
+    struct option_params p;
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+    float call, put, euro_put;
+
+    reprice(&p);                            // European put for the premium
+    euro_put = last_result.put;             // The LCD waits serve the UART, which reprices
+    lcd_clear();
+    lcd_puts("Tree...");
+    TRACE(TRACE_EV_PRICE_START, 2);
+    call = binomial_american(&p, BINOMIAL_CALL);
+    put = binomial_american(&p, BINOMIAL_PUT);
+    TRACE(TRACE_EV_PRICE_END, 2);
+
+    // first line: American call and depth, second line: put and its
+    // early-exercise premium over the European put
+    n = 0;
+    memcpy(line, "AmC:", 4);   n += 4;
+    n += fmt_float(&line[n], call, 2, 6, 0);
+    memcpy(&line[n], " N", 2); n += 2;
+    n += fmt_fixed(&line[n], BINOMIAL_STEPS, 0, 1, 0);
+    lcd_clear();
+    lcd_set_cursor(0, 0);
+    lcd_puts(line);
+
+    n = 0;
+    memcpy(line, "AmP:", 4);   n += 4;
+    n += fmt_float(&line[n], put, 2, 6, 0);
+    line[n++] = ' ';
+    n += fmt_float(&line[n], put - euro_put, 2, 5, FMT_PLUS | FMT_ZERO);
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+
+    while (!pressed_key()) {
+        cmd_poll();
+        set_ledbar_percent(last_result.pct_diff);
+    }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
+}
+
+void display_watch_row(uint8_t idx) {
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+
+    lcd_clear();
+
+    // first line: position and strike, '*' while still being repriced;
+    // second line: model call and market price
+    n = 0;
+    line[n++] = 'W';
+    n += fmt_fixed(&line[n], idx + 1, 0, 1, 0);
+    line[n++] = '/';
+    n += fmt_fixed(&line[n], watch_count(), 0, 1, 0);
+    memcpy(&line[n], " K", 2); n += 2;
+    n += fmt_float(&line[n], watch_strike(idx), 2, 6, 0);
+    if (watch_is_dirty(idx)) line[n++] = '*';
+    line[n] = '\0';
+    lcd_set_cursor(0, 0);
+    lcd_puts(line);
+
+    n = 0;
+    memcpy(line, "C:", 2);     n += 2;
+    n += fmt_float(&line[n], watch_call(idx), 2, 5, FMT_ZERO);
+    memcpy(&line[n], " M:", 3); n += 3;
+    n += fmt_float(&line[n], watch_market(idx), 2, 5, FMT_ZERO);
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+}
+
+void show_watch_until_key(void) {
+    uint8_t idx = watch_selected();
+    uint8_t dirty = watch_is_dirty(idx);
+    uint16_t version = params_version();
+    char key;
+
+    display_watch_row(idx);
+    while (1) {
+        cmd_poll();
+        watch_idle();
+        if (dirty != watch_is_dirty(idx) || version != params_version()) {
+            dirty = watch_is_dirty(idx);
+            version = params_version();
+            display_watch_row(idx);
+        }
+        set_ledbar_percent(watch_pct_diff(idx));
+
+        key = pressed_key();
+        if (key == 'D') {
+            idx = watch_select_next();      // Loads it into the live parameters
+            stats_reset();                  // Deviation history is per contract
+        } else if (key) {
+            break;
+        }
+    }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
+}
+
+void display_stats(const struct stats_summary *st, int page) {
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+    int8_t signal = stats_signal(st);
+
+    lcd_clear();
+    n = 0;
+    if (page == 0) {
+        // first line: window mean and std dev, second line: z-score and signal
+        memcpy(line, "Av", 2);     n += 2;
+        n += fmt_float(&line[n], st->mean, 1, 6, FMT_PLUS);
+        memcpy(&line[n], " sd", 3); n += 3;
+        n += fmt_float(&line[n], st->stddev, 1, 5, 0);
+        lcd_set_cursor(0, 0);
+        lcd_puts(line);
+
+        n = 0;
+        line[n++] = 'z';
+        n += fmt_float(&line[n], st->z, 2, 5, FMT_PLUS);
+        memcpy(&line[n], signal == STATS_SELL ? " SELL" : signal == STATS_BUY ? " BUY " : " HOLD", 5);
+        n += 5;
+        line[n] = '\0';
+    } else {
+        // first line: min and max since reset, second line: EWMA, window size and span
+        memcpy(line, "Lo", 2);     n += 2;
+        n += fmt_float(&line[n], st->min, 1, 6, FMT_PLUS);
+        memcpy(&line[n], "Hi", 2); n += 2;
+        n += fmt_float(&line[n], st->max, 1, 6, FMT_PLUS);
+        lcd_set_cursor(0, 0);
+        lcd_puts(line);
+
+        n = 0;
+        memcpy(line, "Ew", 2);     n += 2;
+        n += fmt_float(&line[n], st->ewma, 1, 6, FMT_PLUS);
+        memcpy(&line[n], " n", 2); n += 2;
+        n += fmt_fixed(&line[n], st->count, 0, 1, 0);
+        line[n++] = ' ';
+        n += fmt_fixed(&line[n], st->span, 0, 1, 0);
+        line[n++] = 's';
+        line[n] = '\0';
+    }
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+}
+
+void show_stats_until_key(void) {
+    struct option_params p;
+    struct stats_summary st;
+    int page = 0;
+    uint16_t shown;
+    char key;
+
+    reprice(&p);                            // Record the current quote
+    stats_summary(&st);
+    shown = st.added;
+    display_stats(&st, page);
+
+    while (1) {
+        cmd_poll();                         // Streamed quotes add samples
+        watch_idle();
+        stats_summary(&st);
+        if (st.added != shown) {
+            shown = st.added;
+            display_stats(&st, page);
+        }
+        set_ledbar_zscore(st.z);
+
+        key = pressed_key();
+        if (key == '*') {
+            page ^= 1;
+            display_stats(&st, page);
+        } else if (key) {
+            break;
+        }
+    }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
+}
+
+void show_smile_until_key(void) {
+    struct option_params p;
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+    float call;
 
+    reprice(&p);                            // p.volatility is the vol priced with
+    call = last_result.call;
+    lcd_clear();
+    lcd_puts(volsurf_smile() ? "Smile: ON" : "Smile: OFF");
+
+    // second line: vol in use and the call it gives
+    n = 0;
+    memcpy(line, "v", 1);      n += 1;
+    n += fmt_float(&line[n], p.volatility * 100.0f, 1, 4, 0);
+    memcpy(&line[n], "% C:", 4); n += 4;
+    n += fmt_float(&line[n], call, 2, 5, FMT_ZERO);
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+
+    while (!pressed_key()) {
+        cmd_poll();
+        watch_idle();
+    }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
+}
+
+void display_scenario(const struct scenario *s, float centre) {
+    char line[LCD_LINE_BUF];
+    uint8_t n;
+
+    lcd_clear();
+
+    // first line: centre spot and encoder step, second line: call at the
+    // -8% and +8% ends of the sweep
+    n = 0;
+    line[n++] = 'S';
+    n += fmt_float(&line[n], centre, 2, 6, 0);
+    line[n] = '\0';
+    lcd_set_cursor(0, 0);
+    lcd_puts(line);
+    lcd_set_cursor(0, 13);
+    lcd_puts(step_labels[step_idx]);
+
+    n = 0;
+    line[n++] = 'C';
+    n += fmt_float(&line[n], s->call[0], 2, 5, FMT_ZERO);
+    memcpy(&line[n], "..", 2); n += 2;
+    n += fmt_float(&line[n], s->call[SCEN_COUNT - 1], 2, 5, FMT_ZERO);
+    lcd_set_cursor(1, 0);
+    lcd_puts(line);
+}
+
+/**
+ * Sweep the spot around the stock price and keep the sweep live: the
+ * encoder moves the centre by the edit step ('*' cycles the step), and
+ * quotes or vol changes from the UART reprice it. Any other key returns
+ * to the menu; the stock price itself is left alone. The LED bar lights
+ * the scenarios in which the market price is rich.
+ */
+void show_scenario_until_key(void) {
+    struct option_params p;
+    struct scenario s;
+    float offset = 0.0f;                    // Centre minus the stock price
+    uint16_t version = 1;                   // Odd: matches no stable version
+    uint8_t moved = 1;
+    char key;
+
+    encoder_get_delta();                    // Drop movement from before the screen
+    while (1) {
+        cmd_poll();
+        watch_idle();
+
+        int16_t delta = encoder_get_delta();
+        if (delta) {
+            TRACE(TRACE_EV_ENC, delta);
+            offset += delta * encoder_step;
+            moved = 1;
+        }
+        if (moved || version != params_version() + volsurf_version()) {
+            version = params_version() + volsurf_version();
+            moved = 0;
+            params_snapshot(&p);
+            if (p.stock_price + offset < 0.01f) offset = 0.01f - p.stock_price;
+            p.stock_price += offset;
+            volsurf_apply(&p);
+            TRACE(TRACE_EV_PRICE_START, 4);
+            scenario_price(&s, &p);
+            TRACE(TRACE_EV_PRICE_END, 4);
+            display_scenario(&s, p.stock_price);
+        }
+        set_ledbar_mask(scenario_rich_mask(&s, p.market_price));
+
+        key = pressed_key();
+        if (key == '*') {
+            step_idx = (step_idx + 1) % NUM_STEPS;
+            encoder_step = step_values[step_idx];
+            display_scenario(&s, p.stock_price);
+        } else if (key) {
+            break;
+        }
     }
+    show_main_menu();
+    state_variable = STATE_MODE_SELECT;
 }
 
 void show_main_menu() {
     lcd_clear();
-    lcd_puts("1:S 2:K 3:T");
+    lcd_puts("1S 2K 3T 4V 5r");
     lcd_set_cursor(1,0);
-    lcd_puts("4:V 5:r 6:MP #:Go");
+    lcd_puts("6M 7q ABD089 #Go");
 }
 void display_prompt_param(int param) {
     lcd_clear();
@@ -299,53 +621,24 @@ void display_prompt_param(int param) {
         case PARAM_VOLATILITY:   lcd_puts("Set Volatility:"); break;
         case PARAM_RISK_FREE:    lcd_puts("Set Risk-Free r:"); break;
         case PARAM_MKT_PRICE:    lcd_puts("Set MKT price"); break;
+        case PARAM_DIV_YIELD:    lcd_puts("Set Div Yield q:"); break;
         default:                 lcd_puts("Set Param:");     break;
     }
     lcd_set_cursor(1,0);
 }
 
-float range_for(int param) {
-    switch (param) {
-      case 1:
-      case 2:                   return 1000.0f;
-      case 3:                   return   2.0f;
-      case 4:                   return   1.0f;
-      case 5:                   return   0.10f;
-      case 6:                   return   100.0f;
-      default:                  return   1.0f;
-    }
-}  
-
 void show_edit_value(void) {
     int16_t delta = encoder_get_delta();
     if (delta) {
-        __delay_cycles(20000);
+        TRACE(TRACE_EV_ENC, delta);
+        DELAY_MS(20);
         edit_value += delta * encoder_step;
         float r = range_for(current_param);
         if (edit_value < 0) edit_value = 0;
         if (edit_value > r) edit_value = r;
 
-                // Compute integer and fractional parts
-                int v = (int)(edit_value * 100 + 0.5f);
-                int whole = v / 100;
-                int frac  = v % 100;
-                char s[7];
-                int idx = 0;
-                if (whole >= 100) {
-                    s[idx++] = '0' + (whole / 100);
-                    s[idx++] = '0' + ((whole / 10) % 10);
-                    s[idx++] = '0' + (whole % 10);
-                } else if (whole >= 10) {
-                    s[idx++] = '0' + (whole / 10);
-                    s[idx++] = '0' + (whole % 10);
-                } else {
-                    s[idx++] = '0';
-                    s[idx++] = '0' + whole;
-                }
-                s[idx++] = '.';
-                s[idx++] = '0' + (frac / 10);
-                s[idx++] = '0' + (frac % 10);
-                s[idx]   = '\0';
+            char s[LCD_LINE_BUF];
+            fmt_float(s, edit_value, 2, 5, FMT_ZERO);
             lcd_set_cursor(1, 0);
             lcd_puts(s);
             lcd_puts("  ");  // overwrite extra digits
@@ -353,42 +646,11 @@ void show_edit_value(void) {
     }
 }
 
-void set_ledbar_percent(float pct) {
-    if (pct < 0.0f) pct = -pct;
-    if (pct > 100.0f) pct = 100.0f;
-     
-    int bars = pct;         
-    if (pct > 0.0f && bars == 0) // make sure ANY non‑zero percent lights at least 1
-        bars = 1;
-    if (bars > 8)                // cap at 8 bars
-        bars = 8;
-
-    int mask = 0;
-    if (bars > 0) {
-        mask = (int)(((1u << bars) -1 ) << (8 - bars));
-    }
-    while (i2c_busy);
-    i2c_write_led(mask);
-}
-
-
-float norm_cdf(float x) {           // Cumulative normal function approximation
-    return 0.5f * (1.0f + erff(x / sqrtf(2.0f)));
-}
-
-float black_scholes_call(float S, float K, float T, float r, float sigma) {
-
-    float sqrtT = sqrtf(T);
-
-    float d1 = (logf(S / K) + (r + 0.5f * sigma * sigma) * T) / (sigma * sqrtT);
-    float d2 = d1 - sigma * sqrtT;
-    return S * norm_cdf(d1) - K * expf(-r * T) * norm_cdf(d2);
-}
-
 int main(void)
 {
     
     WDTCTL = WDTPW | WDTHOLD;               // Stop watchdog timer
+    setup_clock();
 
 
     P1DIR |= BIT0;
@@ -397,26 +659,42 @@ int main(void)
     setup_keypad();
     setup_heartbeat();
     setup_encoder();
+    setup_trace();
+    setup_uart();
 
     setup_lcd();
 
 
-        // Initial menu display
-    show_main_menu();
+    // Warm start: restore the last confirmed parameters and result
+    struct option_params saved;
+    struct bs_result saved_result;
+    uint8_t saved_smile;
+    int warm = persist_load(&saved, &saved_result, &saved_smile);
+    if (warm) {
+        uint8_t same = watch_restore(&saved);
+        // A smile-mode result depends on surface cells the record does not
+        // hold, and the surface version restarts at 0; reprice it instead.
+        // So does one for a contract the watchlist has moved on from.
+        if (same && !saved_smile && !volsurf_smile()) pricer_restore(&saved_result);
+    } else {
+        watch_load_selected();
+        show_main_menu();       // Initial menu display
+    }
 
     send_buff = 0;
     ready_to_send = 0;
 
     
                                             // to activate previously configured port settings
-    UCB0CTLW0 &= ~UCSWRST;                // Take out of reset
     PM5CTL0 &= ~LOCKLPM5;                   // Disable the GPIO power-on default high-impedance mode    
-
-    UCB0IE |= UCTXIE0;
-    UCB0IE |= UCRXIE0;
+    i2c_master_start();                     // Take out of reset, enable interrupts
 
     __enable_interrupt();
 
+    if (warm) {
+        show_result_until_key();    // Cached unless it has to reprice
+    }
+
     while(1)
     {
         if (state_variable == STATE_INPUT_PARAM) {
@@ -424,6 +702,9 @@ int main(void)
         }
         process_keypad();
 
+        cmd_poll();
+        watch_idle();           // Reprices at most one watchlist contract
+
      }
 }
 
@@ -435,19 +716,6 @@ int main(void)
 __interrupt void Timer_B0_ISR(void) {
     TB0CCTL0 &= ~CCIFG;
     P6OUT ^= BIT6;
+    uptime_s++;
 }
 
-#pragma vector=EUSCI_B0_VECTOR
-__interrupt void EUSCI_B0_ISR(void){
-    int current = UCB0IV;
-    switch(current) {
-        case 0x18:  // TXIFG
-            UCB0TXBUF = send_buff;
-            i2c_busy = 0;
-            break;
-        default:
-            break;
-    }
-} 
-
-
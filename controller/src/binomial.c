@@ -0,0 +1,177 @@
+/**
+ * @file
+ * @brief Cox-Ross-Rubinstein tree for American options.
+ *
+ * The tree is rolled back in place over a single array of N + 1 nodes.
+ * Prices are normalised by the strike and held as unsigned Q8.24, and the
+ * per-step weights disc * p and disc * (1 - p) as Q0.32, so the inner loop
+ * is two 32x32 multiplies, an add and a compare. The float maths (one
+ * expf per step) stays outside it.
+ *
+ * Only puts are rolled back. A call is priced as the put with spot and
+ * strike, and r and q, swapped (McDonald-Schroder symmetry, exact for
+ * American options and for a CRR tree). A put's value never exceeds its
+ * strike, so node values stay below 1.0, and spots are only needed below
+ * the strike: each row's ladder starts at the highest such node and is
+ * walked down by d^2. Nothing in the tree can saturate, whatever S/K is.
+ */
+#include <math.h>
+#include "binomial.h"
+
+#define Q24_ONE   16777216.0f               // 1.0 in Q8.24
+#define Q30_ONE   1073741824.0f             // 1.0 in Q2.30
+#define Q32_ONE   4294967296.0f             // 1.0 in Q0.32
+#define Q32_MAX   0xFFFFFFFFUL
+
+// Static: the default stack is far smaller than the tree
+static uint32_t nodes[BINOMIAL_STEPS + 1];
+
+// Products are rounded, not truncated: a truncation bias of one LSB per
+// step adds up over N steps and along the spot ladder.
+static uint32_t mul_q32(uint32_t a, uint32_t b) {
+    return (uint32_t)(((uint64_t)a * b + 0x80000000UL) >> 32);
+}
+
+// Spot times d^2; the ladder only moves down, so this cannot overflow
+static uint32_t mul_q30(uint32_t a, uint32_t b) {
+    return (uint32_t)(((uint64_t)a * b + 0x20000000UL) >> 30);
+}
+
+/**
+ * Highest node of row j whose spot s0 u^(2i - j) is below the strike,
+ * i.e. i < (j - ln(s0) / ln(u)) / 2.
+ *
+ * @param: ln_s0_u ln(s0) / ln(u).
+ * @param: j       Row, which has nodes 0..j.
+ *
+ * @return: The node, or -1 if the whole row is at or above the strike.
+ */
+static int16_t top_itm(float ln_s0_u, uint16_t j) {
+    float x = 0.5f * ((float)j - ln_s0_u);
+    int16_t i;
+
+    if (x <= 0.0f) return -1;
+    if (x > (float)j) return (int16_t)j;
+    i = (int16_t)x;
+    return ((float)i == x) ? i - 1 : i;
+}
+
+static uint32_t exercise(uint32_t spot) {
+    const uint32_t one = (uint32_t)Q24_ONE;
+    return (spot < one) ? one - spot : 0;
+}
+
+/**
+ * A put with no diffusion: the spot drifts to S e^((r-q)t), so the value
+ * is the best of K e^-rt - S e^-qt over exercise times t in [0, T]. That
+ * is reached at t = 0, at T, or where its derivative vanishes,
+ * e^((r-q)t) = rK / (qS).
+ */
+static float deterministic_put(float S, float K, float T, float r, float q) {
+    float best = K - S;
+    float v = K * expf(-r * T) - S * expf(-q * T);
+    if (v > best) best = v;
+    if (r > 0.0f && q > 0.0f && r != q) {
+        float t = logf(r * K / (q * S)) / (r - q);
+        if (t > 0.0f && t < T) {
+            v = K * expf(-r * t) - S * expf(-q * t);
+            if (v > best) best = v;
+        }
+    }
+    return (best > 0.0f) ? best : 0.0f;
+}
+
+/**
+ * Price an American option on an N-step CRR tree.
+ *
+ * @param: p     Contract; market_price is not used.
+ * @param: kind  BINOMIAL_CALL or BINOMIAL_PUT.
+ * @param: steps Tree depth, 1..BINOMIAL_STEPS.
+ *
+ * @return: Option price, or -1 if the inputs cannot be represented (a
+ *          single step moving the spot by a factor of 2 or more).
+ */
+float binomial_price(const struct option_params *p, uint8_t kind, uint16_t steps) {
+    float S = p->stock_price;
+    float K = p->strike_price;
+    float r = p->risk_free_rate;
+    float q = p->dividend_yield;
+    float T = p->time_to_exp;
+    float x;
+    uint16_t i, j;
+
+    if (kind == BINOMIAL_CALL) {            // Price the symmetric put
+        x = S; S = K; K = x;
+        x = r; r = q; q = x;
+    }
+    if (steps < 1) steps = 1;
+    if (steps > BINOMIAL_STEPS) steps = BINOMIAL_STEPS;
+
+    // Degenerate contracts: exercise now, or the deterministic path
+    if (K <= 0.0f) return 0.0f;
+    if (S <= 0.0f || T <= 0.0f) return (K > S) ? K - S : 0.0f;
+    if (p->volatility <= 0.0f) return deterministic_put(S, K, T, r, q);
+
+    float ln_s0 = logf(S / K);
+    float dt = T / steps;
+    float ln_u = p->volatility * sqrtf(dt);
+    if (ln_u >= 0.69f) return -1.0f;
+
+    float u = expf(ln_u);
+    float d = 1.0f / u;
+    float disc = expf(-r * dt);
+    float pu = (expf((r - q) * dt) - d) / (u - d);
+    if (pu < 0.0f) pu = 0.0f;
+    if (pu > 1.0f) pu = 1.0f;
+
+    float wu_f = disc * pu * Q32_ONE;
+    float wd_f = disc * (1.0f - pu) * Q32_ONE;
+    uint32_t wu = (wu_f >= 4294967040.0f) ? Q32_MAX : (uint32_t)wu_f;
+    uint32_t wd = (wd_f >= 4294967040.0f) ? Q32_MAX : (uint32_t)wd_f;
+    uint32_t d2 = (uint32_t)(d * d * Q30_ONE + 0.5f);
+    float ln_s0_u = ln_s0 / ln_u;
+    int16_t k;
+
+    // Payoff at expiry
+    k = top_itm(ln_s0_u, steps);
+    for (i = k + 1; i <= steps; i++) nodes[i] = 0;
+    uint32_t spot = (uint32_t)(expf(ln_s0 + ln_u * (2 * k - steps)) * Q24_ONE);
+    for (; k >= 0; k--) {
+        nodes[k] = exercise(spot);
+        spot = mul_q30(spot, d2);
+    }
+
+    // Roll back; node i at step j only reads nodes i and i + 1 of step j + 1
+    for (j = steps; j-- > 0; ) {
+        for (i = 0; i <= j; i++) {
+            nodes[i] = mul_q32(nodes[i + 1], wu) + mul_q32(nodes[i], wd);
+        }
+        k = top_itm(ln_s0_u, j);
+        spot = (uint32_t)(expf(ln_s0 + ln_u * (2 * k - (int16_t)j)) * Q24_ONE);
+        for (; k >= 0; k--) {
+            uint32_t now = exercise(spot);
+            if (now > nodes[k]) nodes[k] = now;
+            spot = mul_q30(spot, d2);
+        }
+    }
+    return K * (nodes[0] / Q24_ONE);
+}
+
+/**
+ * Price an American option at the configured depth. With
+ * BINOMIAL_RICHARDSON the N and N/2 trees are combined as 2 P(N) - P(N/2)
+ * to cancel the leading 1/N error term. CRR error also oscillates with
+ * where the strike falls between nodes, so this only reliably helps near
+ * the money; it is off by default.
+ */
+float binomial_american(const struct option_params *p, uint8_t kind) {
+    float fine = binomial_price(p, kind, BINOMIAL_STEPS);
+#if BINOMIAL_RICHARDSON
+    float coarse = binomial_price(p, kind, BINOMIAL_STEPS / 2);
+    if (fine >= 0.0f && coarse >= 0.0f) {
+        float x = 2.0f * fine - coarse;
+        return (x > 0.0f) ? x : 0.0f;
+    }
+#endif
+    return fine;
+}
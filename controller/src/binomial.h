@@ -0,0 +1,21 @@
+#ifndef BINOMIAL_H
+#define BINOMIAL_H
+
+#include <stdint.h>
+#include "params.h"
+
+#ifndef BINOMIAL_STEPS
+#define BINOMIAL_STEPS      64              // Tree depth; RAM is 4 * (N + 1) bytes
+#endif
+
+#ifndef BINOMIAL_RICHARDSON
+#define BINOMIAL_RICHARDSON 0               // 1: extrapolate from N and N/2 steps
+#endif
+
+#define BINOMIAL_CALL 0
+#define BINOMIAL_PUT  1
+
+float binomial_price(const struct option_params *p, uint8_t kind, uint16_t steps);
+float binomial_american(const struct option_params *p, uint8_t kind);
+
+#endif // BINOMIAL_H
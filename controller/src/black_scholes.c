@@ -0,0 +1,264 @@
+#include <math.h>
+#include "black_scholes.h"
+
+#define INV_SQRT_2PI 0.39894228f
+
+#define IV_MIN        0.0001f
+#define IV_MAX        5.0f
+#define IV_ITERATIONS 30
+#define IV_TOLERANCE  0.00001f              // Price units
+
+// Beyond this many standard deviations single-precision erff() already
+// rounds to +-1, so N(x) is returned as 1 or 0 without calling it
+#define CDF_SATURATE  6.0f
+
+float norm_cdf(float x) {           // Cumulative normal function approximation
+    if (x > CDF_SATURATE)  return 1.0f;
+    if (x < -CDF_SATURATE) return 0.0f;
+    return 0.5f * (1.0f + erff(x / sqrtf(2.0f)));
+}
+
+float norm_pdf(float x) {
+    return INV_SQRT_2PI * expf(-0.5f * x * x);
+}
+
+/**
+ * Strikes beyond which both CDFs saturate, found without a logf. N(d2)
+ * is 1 when ln(S/K) > a = sigma sqrt(T) (CDF_SATURATE + sigma sqrt(T)) -
+ * drift, and N(d1) is 0 when ln(S/K) < -b = -(CDF_SATURATE sigma sqrt(T)
+ * + drift). ln(x) >= 2 (x - 1) / (x + 1) for x >= 1 and <= it below 1,
+ * which turns both into bounds on K within about 2% of the exact ones.
+ */
+static void saturation_strikes(struct bs_shared *sh) {
+    float S = sh->stock_price;
+    float a = sh->sigma_sqrt_t * (CDF_SATURATE + sh->sigma_sqrt_t) - sh->drift_t;
+    float b = CDF_SATURATE * sh->sigma_sqrt_t + sh->drift_t;
+
+    // Where the bound does not hold, fall back to K = S, or to no strike
+    if (a >= 2.0f)      sh->k_itm = 0.0f;
+    else if (a > 0.0f)  sh->k_itm = S * (2.0f - a) / (2.0f + a);
+    else                sh->k_itm = S;
+    if (b >= 2.0f)      sh->k_otm = HUGE_VALF;
+    else if (b > 0.0f)  sh->k_otm = S * (2.0f + b) / (2.0f - b);
+    else                sh->k_otm = S;
+}
+
+/**
+ * Compute everything that does not depend on the strike.
+ *
+ * q is the continuous dividend yield (Merton); pass 0 for plain
+ * Black-Scholes. A negative T is treated as expired. When there is no
+ * diffusion left (sigma or T zero) or S is not positive, ln(S) and
+ * 1 / (sigma * sqrt(T)) are not computed and every strike takes the
+ * forward-payoff path in bs_call_at(), as do strikes so deep in or out of
+ * the money that N(d1) and N(d2) saturate.
+ */
+void bs_prepare(struct bs_shared *sh, float S, float T, float r, float q, float sigma) {
+    if (T < 0.0f) T = 0.0f;
+    sh->stock_price      = S;
+    sh->sqrt_t           = sqrtf(T);
+    sh->sigma_sqrt_t     = sigma * sh->sqrt_t;
+    sh->drift_t          = (r - q + 0.5f * sigma * sigma) * T;
+    sh->discount         = expf(-r * T);
+    sh->div_discount     = (q == 0.0f) ? 1.0f : expf(-q * T);
+    sh->fwd_s            = S * sh->div_discount;
+    if (sh->sigma_sqrt_t > 0.0f && S > 0.0f) {
+        sh->ln_s             = logf(S);
+        sh->inv_sigma_sqrt_t = 1.0f / sh->sigma_sqrt_t;
+        saturation_strikes(sh);
+    } else {
+        sh->ln_s             = 0.0f;
+        sh->inv_sigma_sqrt_t = 0.0f;
+        sh->k_itm            = 0.0f;
+        sh->k_otm            = HUGE_VALF;
+    }
+}
+
+// Whether strike K needs d1 and d2; if not it takes forward_payoff()
+static uint8_t diffuses(const struct bs_shared *sh, float K) {
+    return sh->inv_sigma_sqrt_t != 0.0f && K > 0.0f && K >= sh->k_itm && K <= sh->k_otm;
+}
+
+/**
+ * Closed form for a call with nothing left to diffuse: max(S e^-qT -
+ * K e^-rT, 0). This is the intrinsic value at expiry, the discounted
+ * forward payoff at zero vol, and exact for a zero strike or underlying
+ * and wherever both CDFs saturate. N(d1) and N(d2) become a step, so the
+ * put and the delta stay consistent.
+ */
+static float forward_payoff(const struct bs_shared *sh, float K, struct bs_terms *t) {
+    float fwd = sh->fwd_s - K * sh->discount;
+    uint8_t itm = fwd > 0.0f;
+
+    t->d1  = t->d2  = itm ? CDF_SATURATE : -CDF_SATURATE;
+    t->nd1 = t->nd2 = itm ? 1.0f : 0.0f;
+    return itm ? fwd : 0.0f;
+}
+
+/**
+ * Terms for spot S * factor from terms prepared at S. Only S, S e^-qT and
+ * ln(S) depend on the spot, and ln(S * factor) is ln(S) + ln(factor), so
+ * there is no logf when ln(factor) is a constant.
+ *
+ * @param: out       Receives the shifted terms.
+ * @param: sh        Output of bs_prepare().
+ * @param: factor    Spot multiplier, > 0.
+ * @param: ln_factor ln(factor).
+ */
+void bs_shift_spot(struct bs_shared *out, const struct bs_shared *sh, float factor, float ln_factor) {
+    *out = *sh;
+    out->stock_price = sh->stock_price * factor;
+    out->fwd_s       = sh->fwd_s * factor;
+    out->ln_s        = sh->ln_s + ln_factor;
+    out->k_itm       = sh->k_itm * factor;
+    out->k_otm       = sh->k_otm * factor;
+}
+
+/**
+ * bs_call_at() with ln(K) supplied, for pricing one strike against
+ * several spots. ln_k is not used when the contract is degenerate or
+ * the strike saturates.
+ */
+float bs_call_ln_k(const struct bs_shared *sh, float K, float ln_k, struct bs_terms *t) {
+    t->sqrt_t       = sh->sqrt_t;
+    t->sigma_sqrt_t = sh->sigma_sqrt_t;
+    t->discount     = sh->discount;
+    t->div_discount = sh->div_discount;
+    if (!diffuses(sh, K)) return forward_payoff(sh, K, t);
+    t->d1  = (sh->ln_s - ln_k + sh->drift_t) * sh->inv_sigma_sqrt_t;
+    t->d2  = t->d1 - sh->sigma_sqrt_t;
+    t->nd1 = norm_cdf(t->d1);
+    t->nd2 = norm_cdf(t->d2);
+    return sh->fwd_s * t->nd1 - K * t->discount * t->nd2;
+}
+
+/**
+ * Price the call at strike K from prepared terms: one logf and two
+ * normal CDFs per strike, fewer when it is degenerate or deep in or out
+ * of the money.
+ *
+ * @param: sh Output of bs_prepare().
+ * @param: K  Strike.
+ * @param: t  Receives the terms of this evaluation.
+ *
+ * @return: Call price.
+ */
+float bs_call_at(const struct bs_shared *sh, float K, struct bs_terms *t) {
+    float ln_k = diffuses(sh, K) ? logf(K) : 0.0f;
+    return bs_call_ln_k(sh, K, ln_k, t);
+}
+
+/**
+ * Price call and put at strike K from the same d1/d2 and CDF values.
+ * The put uses N(-d) = 1 - N(d), so it costs two multiplies, not a
+ * second evaluation.
+ *
+ * @param: sh  Output of bs_prepare().
+ * @param: K   Strike.
+ * @param: t   Receives the terms of this evaluation.
+ * @param: put Receives the put price.
+ *
+ * @return: Call price.
+ */
+float bs_pair_at(const struct bs_shared *sh, float K, struct bs_terms *t, float *put) {
+    float call = bs_call_at(sh, K, t);
+    *put = K * t->discount * (1.0f - t->nd2) - sh->fwd_s * (1.0f - t->nd1);
+    return call;
+}
+
+static float call_from_terms(float S, float K, float T, float r, float q, float sigma, struct bs_terms *t) {
+    struct bs_shared sh;
+    bs_prepare(&sh, S, T, r, q, sigma);
+    return bs_call_at(&sh, K, t);
+}
+
+float black_scholes_call(float S, float K, float T, float r, float sigma) {
+    struct bs_terms t;
+    return call_from_terms(S, K, T, r, 0.0f, sigma, &t);
+}
+
+void bs_price(const struct option_params *p, struct bs_result *out) {
+    struct bs_shared sh;
+    bs_prepare(&sh, p->stock_price, p->time_to_exp, p->risk_free_rate,
+               p->dividend_yield, p->volatility);
+    out->call = bs_pair_at(&sh, p->strike_price, &out->terms, &out->put);
+    // compute percent difference vs market price
+    out->pct_diff = 0.0f;
+    if (out->call != 0.0f) {
+        out->pct_diff = (p->market_price - out->call) / out->call * 100.0f;
+    }
+}
+
+/**
+ * Greeks of the call, reusing the terms bs_price() already computed.
+ *
+ * @param: p   Parameters res was priced from.
+ * @param: res Result of bs_price() for p.
+ * @param: out Receives the Greeks.
+ */
+void bs_greeks(const struct option_params *p, const struct bs_result *res, struct bs_greeks *out) {
+    const struct bs_terms *t = &res->terms;
+    float pdf = 0.0f;
+    float decay = 0.0f;                     // Time decay of the vol premium
+
+    // A degenerate contract has a step payoff: no gamma, vega or decay
+    if (t->sigma_sqrt_t > 0.0f && p->stock_price > 0.0f) {
+        pdf = norm_pdf(t->d1) * t->div_discount;
+    }
+    if (pdf > 0.0f) {
+        out->gamma = pdf / (p->stock_price * t->sigma_sqrt_t);
+        decay = p->stock_price * pdf * p->volatility / (2.0f * t->sqrt_t);
+    } else {
+        out->gamma = 0.0f;
+    }
+    out->delta = t->div_discount * t->nd1;
+    out->vega  = p->stock_price * pdf * t->sqrt_t;
+    out->theta = -decay
+                 - p->risk_free_rate * p->strike_price * t->discount * t->nd2
+                 + p->dividend_yield * p->stock_price * t->div_discount * t->nd1;
+}
+
+/**
+ * Volatility at which the model price equals the market price.
+ *
+ * Newton's method on vega, falling back to bisection when a step leaves
+ * the bracket or vega vanishes far from the money.
+ *
+ * @param: p Parameters; volatility is used as the starting guess.
+ *
+ * @return: Implied volatility, or -1 if the market price is outside the
+ *          no-arbitrage bounds max(S e^-qT - K e^-rT, 0) < C < S e^-qT.
+ */
+float bs_implied_vol(const struct option_params *p) {
+    float S = p->stock_price;
+    float K = p->strike_price;
+    float T = p->time_to_exp;
+    float r = p->risk_free_rate;
+    float q = p->dividend_yield;
+    float target = p->market_price;
+    float lo = IV_MIN;
+    float hi = IV_MAX;
+    int i;
+
+    float fwd_s = S * expf(-q * T);
+    float intrinsic = fwd_s - K * expf(-r * T);
+    if (intrinsic < 0.0f) intrinsic = 0.0f;
+    if (target <= intrinsic || target >= fwd_s || T <= 0.0f) return -1.0f;
+
+    float sigma = p->volatility;
+    if (sigma < lo || sigma > hi) sigma = 0.3f;
+
+    for (i = 0; i < IV_ITERATIONS; i++) {
+        struct bs_terms t;
+        float diff = call_from_terms(S, K, T, r, q, sigma, &t) - target;
+        if (fabsf(diff) < IV_TOLERANCE) break;
+
+        if (diff > 0.0f) hi = sigma;        // Price rises with sigma
+        else             lo = sigma;
+
+        float vega = fwd_s * norm_pdf(t.d1) * t.sqrt_t;
+        float next = (vega > 1e-6f) ? sigma - diff / vega : lo - 1.0f;
+        sigma = (next > lo && next < hi) ? next : 0.5f * (lo + hi);
+    }
+    return sigma;
+}
@@ -0,0 +1,72 @@
+#ifndef BLACK_SCHOLES_H
+#define BLACK_SCHOLES_H
+
+#include "params.h"
+
+/**
+ * Intermediate terms of one Black-Scholes evaluation.
+ */
+struct bs_terms {
+    float sqrt_t;           // sqrt(T)
+    float sigma_sqrt_t;     // sigma * sqrt(T)
+    float discount;         // exp(-r * T)
+    float div_discount;     // exp(-q * T)
+    float d1;
+    float d2;
+    float nd1;              // N(d1)
+    float nd2;              // N(d2)
+};
+
+/**
+ * Terms that do not depend on the strike, shared by every strike priced
+ * against the same S, T, r and sigma.
+ */
+struct bs_shared {
+    float stock_price;
+    float fwd_s;            // S * exp(-q * T)
+    float ln_s;             // ln(S)
+    float sqrt_t;
+    float sigma_sqrt_t;
+    float inv_sigma_sqrt_t;
+    float drift_t;          // (r - q + sigma^2 / 2) * T
+    float discount;         // exp(-r * T)
+    float div_discount;     // exp(-q * T)
+    float k_itm;            // Below this strike N(d1) and N(d2) are both 1
+    float k_otm;            // Above it both are 0
+};
+
+/**
+ * A priced contract: call and put from one evaluation, deviation of the
+ * market (call) price from the model, and the terms it was computed from.
+ */
+struct bs_result {
+    float call;
+    float put;
+    float pct_diff;         // (market - model) / model * 100
+    struct bs_terms terms;
+};
+
+/**
+ * Sensitivities of the call, per unit of the underlying parameter
+ * (vega per 1.00 of volatility, theta per year).
+ */
+struct bs_greeks {
+    float delta;
+    float gamma;
+    float vega;
+    float theta;
+};
+
+float norm_cdf(float x);
+float norm_pdf(float x);
+float black_scholes_call(float S, float K, float T, float r, float sigma);
+void  bs_prepare(struct bs_shared *sh, float S, float T, float r, float q, float sigma);
+void  bs_shift_spot(struct bs_shared *out, const struct bs_shared *sh, float factor, float ln_factor);
+float bs_call_ln_k(const struct bs_shared *sh, float K, float ln_k, struct bs_terms *t);
+float bs_call_at(const struct bs_shared *sh, float K, struct bs_terms *t);
+float bs_pair_at(const struct bs_shared *sh, float K, struct bs_terms *t, float *put);
+void  bs_price(const struct option_params *p, struct bs_result *out);
+void  bs_greeks(const struct option_params *p, const struct bs_result *res, struct bs_greeks *out);
+float bs_implied_vol(const struct option_params *p);
+
+#endif // BLACK_SCHOLES_H
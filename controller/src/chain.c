@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @brief Option-chain strip pricing.
+ *
+ * sqrt(T), sigma * sqrt(T), exp(-rT) and ln(S) are computed once per strip
+ * by bs_prepare(); each strike then costs one logf and two normal CDFs.
+ * In smile mode every strike has its own vol, so the shared terms are
+ * prepared per strike.
+ */
+#include "chain.h"
+#include "black_scholes.h"
+#include "volsurf.h"
+
+#define LEDBAR_LEDS 8
+
+static float chain_spacing = CHAIN_DEFAULT_SPACING;
+static uint8_t chain_count = CHAIN_MAX;
+
+void chain_set_spacing(float spacing) {
+    if (spacing > 0.0f) chain_spacing = spacing;
+}
+
+float chain_get_spacing(void) {
+    return chain_spacing;
+}
+
+// Odd counts keep the contract's strike in the middle of the strip
+void chain_set_count(uint8_t count) {
+    if (count < 1) count = 1;
+    if (count > CHAIN_MAX) count = CHAIN_MAX;
+    chain_count = count | 1;
+}
+
+uint8_t chain_get_count(void) {
+    return chain_count;
+}
+
+/**
+ * Price the strip around p->strike_price. Strikes that would be zero or
+ * negative are dropped from the low end.
+ *
+ * @param: c Receives the strikes and call prices, lowest strike first.
+ * @param: p Contract parameters; strike_price is the centre.
+ */
+void chain_price(struct chain *c, const struct option_params *p) {
+    struct bs_shared sh;
+    struct bs_terms t;
+    uint8_t i;
+    float k = p->strike_price - chain_spacing * (chain_count / 2);
+    uint8_t smile = volsurf_smile();
+    float inv_s = 1.0f / p->stock_price;
+
+    if (!smile) {
+        bs_prepare(&sh, p->stock_price, p->time_to_exp, p->risk_free_rate,
+                   p->dividend_yield, p->volatility);
+    }
+
+    c->count = 0;
+    for (i = 0; i < chain_count; i++, k += chain_spacing) {
+        if (k <= 0.0f) continue;
+        if (smile) {
+            bs_prepare(&sh, p->stock_price, p->time_to_exp, p->risk_free_rate,
+                       p->dividend_yield, volsurf_vol(k * inv_s, p->time_to_exp));
+        }
+        c->strike[c->count] = k;
+        c->call[c->count] = bs_call_at(&sh, k, &t);
+        c->count++;
+    }
+}
+
+/**
+ * LED bar mask with one LED marking where the market price sits in the
+ * strip. Call prices fall as strikes rise, so the LED moves right as the
+ * market price points to a higher strike.
+ *
+ * @param: c            A priced strip.
+ * @param: market_price Market price of the contract.
+ *
+ * @return: One-hot mask, bit 7 = lowest strike.
+ */
+uint8_t chain_market_mask(const struct chain *c, float market_price) {
+    float pos = 0.0f;                       // Fractional index into the strip
+    uint8_t i;
+
+    if (c->count < 2) return 0x80 >> (LEDBAR_LEDS / 2);
+
+    if (market_price <= c->call[c->count - 1]) {
+        pos = (float)(c->count - 1);
+    } else if (market_price < c->call[0]) {
+        for (i = 0; i + 1 < c->count; i++) {
+            if (market_price <= c->call[i] && market_price > c->call[i + 1]) {
+                pos = i + (c->call[i] - market_price) / (c->call[i] - c->call[i + 1]);
+                break;
+            }
+        }
+    }
+    uint8_t led = (uint8_t)(pos * (LEDBAR_LEDS - 1) / (c->count - 1) + 0.5f);
+    return 0x80 >> led;
+}
@@ -0,0 +1,26 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <stdint.h>
+#include "params.h"
+
+#define CHAIN_MAX             9             // Strikes in a strip
+#define CHAIN_DEFAULT_SPACING 5.0f
+
+/**
+ * A strip of strikes centred on the contract's strike, priced in one batch.
+ */
+struct chain {
+    uint8_t count;
+    float strike[CHAIN_MAX];
+    float call[CHAIN_MAX];
+};
+
+void    chain_set_spacing(float spacing);
+float   chain_get_spacing(void);
+void    chain_set_count(uint8_t count);
+uint8_t chain_get_count(void);
+void    chain_price(struct chain *c, const struct option_params *p);
+uint8_t chain_market_mask(const struct chain *c, float market_price);
+
+#endif // CHAIN_H
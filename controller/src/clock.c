@@ -0,0 +1,22 @@
+#include <msp430.h>
+#include "clock.h"
+
+#define FLL_N ((MCLK_HZ + ACLK_HZ / 2) / ACLK_HZ - 1)   // DCOCLKDIV = (N + 1) * REFO
+
+volatile uint16_t uptime_s = 0;
+
+void setup_clock(void) {
+    FRCTL0 = FRCTLPW | NWAITS_2;            // FRAM needs 2 wait states above 16 MHz
+
+    __bis_SR_register(SCG0);                // Disable FLL while retuning
+    CSCTL3 |= SELREF__REFOCLK;              // REFO as FLL reference
+    CSCTL0 = 0;                             // Clear DCO and MOD
+    CSCTL1 = DCORSEL_7;                     // 24 MHz DCO range
+    CSCTL2 = FLLD_0 + FLL_N;
+    __delay_cycles(3);
+    __bic_SR_register(SCG0);                // Re-enable FLL
+    while (CSCTL7 & (FLLUNLOCK0 | FLLUNLOCK1));  // Wait for lock
+
+    CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK;   // MCLK = SMCLK = DCO, ACLK = REFO
+    CSCTL5 = DIVM_0 | DIVS_0;
+}
@@ -0,0 +1,21 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <msp430.h>
+#include <stdint.h>
+
+// Clock tree, set up by setup_clock(). All delays, timer periods and baud
+// dividers in the controller are derived from these.
+#define MCLK_HZ   24000000UL                // DCO locked to REFO by the FLL
+#define SMCLK_HZ  MCLK_HZ
+#define ACLK_HZ   32768UL                   // REFO
+#define F_CPU     MCLK_HZ
+
+#define DELAY_US(us) __delay_cycles((unsigned long)((MCLK_HZ / 1000000UL) * (us)))
+#define DELAY_MS(ms) __delay_cycles((unsigned long)((MCLK_HZ / 1000UL) * (ms)))
+
+extern volatile uint16_t uptime_s;          // Seconds since reset, counted by the heartbeat
+
+void setup_clock(void);
+
+#endif // CLOCK_H
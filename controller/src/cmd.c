@@ -0,0 +1,380 @@
+/**
+ * @file
+ * @brief Line-based quote protocol on the UART.
+ *
+ * Each line is a sequence of commands, separated by optional spaces and
+ * terminated by CR or LF:
+ *
+ *   S<num> K<num> T<num> V<num> R<num> M<num>   set a parameter
+ *   Q<num>                                      set the dividend yield
+ *   P                                           reply "P <call> <pct diff> <put>"
+ *   G                                           reply "G <delta> <gamma> <vega> <theta>"
+ *   I                                           reply "I <implied vol>" or "I NA"
+ *   C / C<count>                                reply "C <count> <spacing>", then
+ *                                               "C <strike> <call>" for each strike of the
+ *                                               chain strip; a count (1..CHAIN_MAX, even
+ *                                               rounds up) first sets the strip's size
+ *   A                                           reply "A <american call> <american put>"
+ *   Z                                           reply "Z <n> <mean> <sd> <ewma> <z> <signal>"
+ *                                               for the deviation window; signal is
+ *                                               1 sell, -1 buy, 0 hold
+ *   F                                           reply "F <nack> <arb lost> <timeout>
+ *                                               <recovered> <failed>", the LED bar
+ *                                               I2C error counters
+ *   W1 / W0                                     stream a P line after every line with sets
+ *   U1 / U0                                     price with the vol surface instead of V
+ *   X<cell> Y<vol> Y<vol> ...                   write vol surface values from a cell on;
+ *                                               cells are row-major, expiry * VOLS_NM
+ *                                               + moneyness
+ *   D                                           dump the event trace
+ *
+ * Numbers are plain decimals with up to 4 fractional digits ("85.43") and
+ * are parsed as scaled integers; no float parsing. All sets on a line are
+ * applied before anything on it is priced, so a whole quote update costs
+ * one repricing. A line with sets and no query is answered with "OK" (or
+ * with the P line when streaming); errors reply "E <reason>". A line the
+ * UART dropped bytes of is not executed and replies "E overrun".
+ */
+#include <stdint.h>
+#include "cmd.h"
+#include "uart.h"
+#include "params.h"
+#include "pricer.h"
+#include "fmt.h"
+#include "trace.h"
+#include "chain.h"
+#include "binomial.h"
+#include "stats.h"
+#include "volsurf.h"
+#include "i2c_bus.h"
+
+#define CMD_FRAC_DIGITS 4
+#define CMD_INT_LIMIT   100000L             // Integer part must stay below this
+#define CMD_FIELD_MAX   13                  // A space and fmt_fixed()'s longest: sign, 10 digits, point
+#define CMD_REPLY_MAX   (2 + 6 * CMD_FIELD_MAX) // Tag, up to six fields (Z), EOL
+
+static char line_buf[CMD_LINE_MAX];
+static uint8_t line_len = 0;
+static uint8_t line_overflow = 0;
+static uint8_t line_overrun = 0;
+static uint8_t streaming = 0;
+static uint8_t surface_cell = 0;            // Next cell a Y command writes
+
+static int param_for_letter(char c) {
+    switch (c) {
+        case 'S': return PARAM_STOCK_PRICE;
+        case 'K': return PARAM_STRIKE_PRICE;
+        case 'T': return PARAM_TIME_EXP;
+        case 'V': return PARAM_VOLATILITY;
+        case 'R': return PARAM_RISK_FREE;
+        case 'M': return PARAM_MKT_PRICE;
+        case 'Q': return PARAM_DIV_YIELD;
+        default:  return 0;
+    }
+}
+
+/**
+ * Parse an unsigned decimal into an integer scaled by 10^CMD_FRAC_DIGITS.
+ *
+ * @param: s   Cursor, advanced past the number.
+ * @param: out Receives the scaled value.
+ *
+ * @return: 1 on success, 0 if there is no number or it is out of range.
+ */
+static int parse_fixed(const char **s, int32_t *out) {
+    const char *p = *s;
+    int32_t whole = 0;
+    int32_t frac = 0;
+    uint8_t nfrac = 0;
+    uint8_t ndig = 0;
+
+    while (*p >= '0' && *p <= '9') {
+        whole = whole * 10 + (*p++ - '0');
+        ndig++;
+        if (whole >= CMD_INT_LIMIT) return 0;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            if (nfrac < CMD_FRAC_DIGITS) {
+                frac = frac * 10 + (*p - '0');
+                nfrac++;
+            }
+            p++;
+            ndig++;
+        }
+    }
+    if (ndig == 0) return 0;
+    while (nfrac < CMD_FRAC_DIGITS) {
+        frac *= 10;
+        nfrac++;
+    }
+    *out = whole * 10000L + frac;
+    *s = p;
+    return 1;
+}
+
+static void reply_value(char *buf, uint8_t *n, float v, uint8_t prec) {
+    buf[(*n)++] = ' ';
+    *n += fmt_float(&buf[*n], v, prec, 0, 0);
+}
+
+static void reply_line(char *buf, uint8_t n) {
+    buf[n++] = '\n';
+    uart_write(buf, n);
+}
+
+static void reply_price(void) {
+    struct option_params p;
+    char buf[CMD_REPLY_MAX];
+    uint8_t n = 0;
+
+    reprice(&p);
+    buf[n++] = 'P';
+    reply_value(buf, &n, last_result.call, 4);
+    reply_value(buf, &n, last_result.pct_diff, 2);
+    reply_value(buf, &n, last_result.put, 4);
+    reply_line(buf, n);
+}
+
+static void reply_greeks(void) {
+    struct option_params p;
+    struct bs_greeks g;
+    char buf[CMD_REPLY_MAX];
+    uint8_t n = 0;
+
+    reprice(&p);
+    bs_greeks(&p, &last_result, &g);
+    buf[n++] = 'G';
+    reply_value(buf, &n, g.delta, 4);
+    reply_value(buf, &n, g.gamma, 4);
+    reply_value(buf, &n, g.vega, 4);
+    reply_value(buf, &n, g.theta, 4);
+    reply_line(buf, n);
+}
+
+static void reply_iv(void) {
+    struct option_params p;
+    char buf[CMD_REPLY_MAX];
+    uint8_t n = 0;
+
+    params_snapshot(&p);
+    float iv = bs_implied_vol(&p);
+    buf[n++] = 'I';
+    if (iv < 0.0f) {
+        uart_puts("I NA\n");
+        return;
+    }
+    reply_value(buf, &n, iv, 4);
+    reply_line(buf, n);
+}
+
+static void reply_chain(void) {
+    struct option_params p;
+    struct chain c;
+    char buf[CMD_REPLY_MAX];
+    uint8_t i, n;
+
+    params_snapshot(&p);
+    chain_price(&c, &p);
+    n = 0;
+    buf[n++] = 'C';
+    buf[n++] = ' ';
+    n += fmt_fixed(&buf[n], c.count, 0, 0, 0);
+    reply_value(buf, &n, chain_get_spacing(), 2);
+    reply_line(buf, n);
+    for (i = 0; i < c.count; i++) {
+        n = 0;
+        buf[n++] = 'C';
+        reply_value(buf, &n, c.strike[i], 2);
+        reply_value(buf, &n, c.call[i], 4);
+        reply_line(buf, n);
+    }
+}
+
+static void reply_american(void) {
+    struct option_params p;
+    char buf[CMD_REPLY_MAX];
+    uint8_t n = 0;
+
+    params_snapshot(&p);
+    volsurf_apply(&p);
+    buf[n++] = 'A';
+    reply_value(buf, &n, binomial_american(&p, BINOMIAL_CALL), 4);
+    reply_value(buf, &n, binomial_american(&p, BINOMIAL_PUT), 4);
+    reply_line(buf, n);
+}
+
+static void reply_stats(void) {
+    struct stats_summary st;
+    char buf[CMD_REPLY_MAX];
+    uint8_t n = 0;
+
+    stats_summary(&st);
+    buf[n++] = 'Z';
+    buf[n++] = ' ';
+    n += fmt_fixed(&buf[n], st.count, 0, 0, 0);
+    reply_value(buf, &n, st.mean, 2);
+    reply_value(buf, &n, st.stddev, 2);
+    reply_value(buf, &n, st.ewma, 2);
+    reply_value(buf, &n, st.z, 2);
+    buf[n++] = ' ';
+    n += fmt_fixed(&buf[n], stats_signal(&st), 0, 0, 0);
+    reply_line(buf, n);
+}
+
+static void reply_i2c_errors(void) {
+    const uint16_t counts[] = {
+        i2c_errors.nack, i2c_errors.arb_lost, i2c_errors.timeout,
+        i2c_errors.recovered, i2c_errors.failed,
+    };
+    char buf[CMD_REPLY_MAX];
+    uint8_t i, n = 0;
+
+    buf[n++] = 'F';
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        buf[n++] = ' ';
+        n += fmt_fixed(&buf[n], counts[i], 0, 0, 0);
+    }
+    reply_line(buf, n);
+}
+
+/**
+ * Run one command line. Sets are applied as they are parsed; queries are
+ * answered afterwards, in order, so they see every set on the line.
+ *
+ * @param: line NUL-terminated line without the EOL.
+ */
+void cmd_execute(char *line) {
+    const char *p = line;
+    char queries[CMD_LINE_MAX];
+    uint8_t nq = 0;
+    uint8_t sets = 0;
+    uint8_t priced = 0;
+
+    while (*p) {
+        char c = *p++;
+        if (c == ' ' || c == ',') continue;
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+
+        int param = param_for_letter(c);
+        if (param) {
+            int32_t scaled;
+            while (*p == ' ') p++;
+            if (!parse_fixed(&p, &scaled)) {
+                uart_puts("E number\n");
+                return;
+            }
+            params_set(param, (float)scaled * 0.0001f);
+            sets++;
+        } else if (c == 'W') {
+            if (*p != '0' && *p != '1') {
+                uart_puts("E number\n");
+                return;
+            }
+            streaming = (*p++ == '1');
+            queries[nq++] = 'W';
+        } else if (c == 'U') {
+            if (*p != '0' && *p != '1') {
+                uart_puts("E number\n");
+                return;
+            }
+            volsurf_set_smile(*p++ == '1');
+            sets++;
+        } else if (c == 'X' || c == 'Y') {
+            int32_t scaled;
+            while (*p == ' ') p++;
+            if (!parse_fixed(&p, &scaled)) {
+                uart_puts("E number\n");
+                return;
+            }
+            if (c == 'X') {
+                if (scaled % 10000L || scaled >= VOLS_CELLS * 10000L) {
+                    uart_puts("E number\n");
+                    return;
+                }
+                surface_cell = (uint8_t)(scaled / 10000L);
+            } else {
+                if (surface_cell >= VOLS_CELLS) {
+                    uart_puts("E number\n");
+                    return;
+                }
+                volsurf_set_cell(surface_cell++, (float)scaled * 0.0001f);
+                sets++;
+            }
+        } else if (c == 'C') {
+            if (*p >= '0' && *p <= '9') {
+                int32_t scaled;
+                if (!parse_fixed(&p, &scaled) || scaled % 10000L || scaled < 10000L
+                        || scaled > CHAIN_MAX * 10000L) {
+                    uart_puts("E number\n");
+                    return;
+                }
+                chain_set_count((uint8_t)(scaled / 10000L));
+            }
+            queries[nq++] = 'C';
+        } else if (c == 'P' || c == 'G' || c == 'I' || c == 'A' || c == 'Z' || c == 'F' || c == 'D') {
+            queries[nq++] = c;
+        } else {
+            uart_puts("E command\n");
+            return;
+        }
+    }
+
+    uint8_t i;
+    for (i = 0; i < nq; i++) {
+        switch (queries[i]) {
+            case 'P': reply_price(); priced = 1; break;
+            case 'G': reply_greeks();        break;
+            case 'I': reply_iv();            break;
+            case 'C': reply_chain();         break;
+            case 'A': reply_american();      break;
+            case 'Z': reply_stats();         break;
+            case 'F': reply_i2c_errors();    break;
+            case 'D': trace_dump();          break;
+            case 'W': uart_puts("OK\n");     break;
+            default:                         break;
+        }
+    }
+    if (sets && streaming && !priced) {
+        reply_price();
+    } else if (sets && nq == 0) {
+        uart_puts("OK\n");
+    }
+}
+
+/**
+ * Drain the UART RX buffer and execute every complete line.
+ * Call from the main loop, from any loop that waits on the user, and from
+ * the LCD and keypad delays, which outlast the RX ring; a call from inside
+ * a command returns at once.
+ */
+void cmd_poll(void) {
+    static uint8_t polling = 0;
+    int c;
+
+    if (polling) return;                    // Called from a wait inside a command
+    polling = 1;
+    while ((c = uart_getc()) >= 0) {
+        if (c == UART_RX_GAP) {
+            line_overrun = 1;
+        } else if (c == '\r' || c == '\n') {
+            if (line_overrun) {
+                uart_puts("E overrun\n");
+            } else if (line_overflow) {
+                uart_puts("E length\n");
+            } else if (line_len) {
+                line_buf[line_len] = '\0';
+                cmd_execute(line_buf);
+            }
+            line_len = 0;
+            line_overflow = 0;
+            line_overrun = 0;
+        } else if (line_len < CMD_LINE_MAX - 1) {
+            line_buf[line_len++] = (char)c;
+        } else {
+            line_overflow = 1;
+        }
+    }
+    polling = 0;
+}
@@ -0,0 +1,9 @@
+#ifndef CMD_H
+#define CMD_H
+
+#define CMD_LINE_MAX 48                     // Longest accepted command line, including EOL
+
+void cmd_poll(void);
+void cmd_execute(char *line);
+
+#endif // CMD_H
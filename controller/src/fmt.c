@@ -0,0 +1,126 @@
+/**
+ * @file
+ * @brief Decimal formatting for the LCD without hardware or library division.
+ *
+ * Values are handled as integers scaled by 10^prec. Digits are peeled off
+ * with a shift-and-add reciprocal of 10, which is much cheaper on the
+ * MSP430 than the runtime's software divide.
+ */
+#include "fmt.h"
+
+#define FMT_MAX_DIGITS 10   // 2^32 has 10 decimal digits
+
+static const float pow10_table[] = {1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f};
+
+/**
+ * Divide by 10 using shifts and adds only.
+ *
+ * q approximates n * 0.8 / 8 from below and is off by at most one, which
+ * the remainder check corrects (Hacker's Delight, divu10).
+ *
+ * @param: n   Dividend.
+ * @param: rem Receives n % 10.
+ *
+ * @return: n / 10.
+ */
+static uint32_t divu10(uint32_t n, uint8_t *rem) {
+    uint32_t q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    uint32_t r = n - ((q << 3) + (q << 1));                 // n - q * 10
+    if (r > 9) {
+        q++;
+        r -= 10;
+    }
+    *rem = (uint8_t)r;
+    return q;
+}
+
+/**
+ * Format a scaled integer as a fixed-point decimal.
+ *
+ * scaled = 8543 with prec = 2 prints "85.43". At least one integer digit
+ * is always printed. The output is right-aligned in width characters
+ * (including sign and point) and NUL-terminated; dst must hold
+ * max(width, 12) + 1 bytes.
+ *
+ * @param: dst    Destination, typically a position in an LCD line buffer.
+ * @param: scaled Value multiplied by 10^prec.
+ * @param: prec   Digits after the decimal point (0 for none).
+ * @param: width  Minimum field width.
+ * @param: flags  FMT_PLUS and/or FMT_ZERO.
+ *
+ * @return: Number of characters written, excluding the NUL.
+ */
+uint8_t fmt_fixed(char *dst, int32_t scaled, uint8_t prec, uint8_t width, uint8_t flags) {
+    char digits[FMT_MAX_DIGITS];
+    uint8_t ndig = 0;
+    uint8_t len = 0;
+    char sign = 0;
+    uint32_t mag;
+
+    if (scaled < 0) {
+        sign = '-';
+        mag = (uint32_t)0 - (uint32_t)scaled;
+    } else {
+        if (flags & FMT_PLUS) sign = '+';
+        mag = (uint32_t)scaled;
+    }
+
+    if (prec >= FMT_MAX_DIGITS) prec = FMT_MAX_DIGITS - 1;
+
+    do {                                                    // least significant digit first
+        uint8_t r;
+        mag = divu10(mag, &r);
+        digits[ndig++] = '0' + r;
+    } while (mag != 0);
+    while (ndig <= prec) {                                  // keep a leading "0."
+        digits[ndig++] = '0';
+    }
+
+    uint8_t body = ndig + (prec ? 1 : 0) + (sign ? 1 : 0);
+    uint8_t pad = (width > body) ? (width - body) : 0;
+
+    if (!(flags & FMT_ZERO)) {
+        while (pad) { dst[len++] = ' '; pad--; }
+    }
+    if (sign) dst[len++] = sign;
+    while (pad) { dst[len++] = '0'; pad--; }
+
+    while (ndig) {
+        if (ndig == prec) dst[len++] = '.';
+        dst[len++] = digits[--ndig];
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+/**
+ * Round a float to prec decimals and format it with fmt_fixed().
+ *
+ * @param: dst   Destination buffer, see fmt_fixed().
+ * @param: value Value to print; magnitudes beyond int32 are clamped.
+ * @param: prec  Digits after the decimal point, 0-4.
+ * @param: width Minimum field width.
+ * @param: flags FMT_PLUS and/or FMT_ZERO.
+ *
+ * @return: Number of characters written, excluding the NUL.
+ */
+uint8_t fmt_float(char *dst, float value, uint8_t prec, uint8_t width, uint8_t flags) {
+    if (prec > 4) prec = 4;
+    float s = value * pow10_table[prec];
+    int32_t scaled;
+    if (s >= 2147483647.0f) {
+        scaled = INT32_MAX;
+    } else if (s <= -2147483647.0f) {
+        scaled = -INT32_MAX;
+    } else if (s >= 8388608.0f || s <= -8388608.0f) {
+        // From 2^23 up s is already whole, and s + 0.5f would round to even
+        scaled = (int32_t)s;
+    } else {
+        scaled = (int32_t)(s < 0.0f ? s - 0.5f : s + 0.5f);  // round half away from zero
+    }
+    return fmt_fixed(dst, scaled, prec, width, flags);
+}
@@ -0,0 +1,13 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+// Flags for fmt_fixed()/fmt_float()
+#define FMT_PLUS 0x01   // Print '+' for non-negative values
+#define FMT_ZERO 0x02   // Pad to width with zeros instead of spaces
+
+uint8_t fmt_fixed(char *dst, int32_t scaled, uint8_t prec, uint8_t width, uint8_t flags);
+uint8_t fmt_float(char *dst, float value, uint8_t prec, uint8_t width, uint8_t flags);
+
+#endif // FMT_H
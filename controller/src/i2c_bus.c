@@ -0,0 +1,48 @@
+/**
+ * @file
+ * @brief Retry and recovery policy on top of the I2C master's single
+ * transfers.
+ *
+ * Every attempt is bounded by I2C_TIMEOUT_US, so a write returns within
+ * (I2C_RETRIES + 1) deadlines plus at most one bus recovery per attempt,
+ * whatever the slave does. Only the register-level calls in i2c_master.h
+ * touch hardware; the host simulator supplies its own, with fault
+ * injection, and runs this file unchanged.
+ */
+#include "i2c_bus.h"
+#include "i2c_master.h"
+#include "trace.h"
+
+struct i2c_errors i2c_errors;
+
+/**
+ * Write one byte, retrying on NACK, arbitration loss and timeout. A slave
+ * left holding SDA low is clocked free before the next attempt.
+ *
+ * @return: I2C_OK, or the outcome of the last attempt.
+ */
+uint8_t i2c_write(uint8_t addr, uint8_t byte) {
+    uint8_t attempt;
+    uint8_t status = I2C_OK;
+
+    for (attempt = 0; attempt <= I2C_RETRIES; attempt++) {
+        status = i2c_xfer_write(addr, byte);
+        if (status == I2C_OK) return I2C_OK;
+
+        TRACE(TRACE_EV_I2C_ERR, status);
+        switch (status) {
+            case I2C_NACK:     i2c_errors.nack++;     break;
+            case I2C_ARB_LOST: i2c_errors.arb_lost++; break;
+            default:           i2c_errors.timeout++;  break;
+        }
+        if (i2c_sda_low() && i2c_bus_recover()) {
+            i2c_errors.recovered++;
+        }
+    }
+    i2c_errors.failed++;
+    return status;
+}
+
+uint8_t i2c_write_led(uint8_t pattern) {
+    return i2c_write(I2C_LEDBAR_ADDR, pattern);
+}
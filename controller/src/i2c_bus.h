@@ -0,0 +1,26 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+
+#define I2C_LEDBAR_ADDR 0x40
+#define I2C_RETRIES     2                   // Attempts after the first
+
+/**
+ * Failed attempts by cause since reset. A write that succeeds on a retry
+ * still counts its failed attempts; failed counts writes that gave up.
+ */
+struct i2c_errors {
+    uint16_t nack;
+    uint16_t arb_lost;
+    uint16_t timeout;
+    uint16_t recovered;                     // Bus recoveries that freed SDA
+    uint16_t failed;
+};
+
+extern struct i2c_errors i2c_errors;
+
+uint8_t i2c_write(uint8_t addr, uint8_t byte);
+uint8_t i2c_write_led(uint8_t pattern);
+
+#endif // I2C_BUS_H
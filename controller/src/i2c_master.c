@@ -1,21 +1,45 @@
+/**
+ * @file
+ * @brief eUSCI_B0 I2C master: single transfers with a deadline, and bus
+ * recovery.
+ *
+ * A transfer is started here and finished by the ISR, which records how
+ * it ended. The caller waits against TB3, the trace timer, which
+ * i2c_master_setup() starts if setup_trace() has not, so a missing slave,
+ * a slave stretching SCL forever or a lost arbitration all return within
+ * I2C_TIMEOUT_US. Retries and error counting are in i2c_bus.c.
+ */
 #include "msp430fr2355.h"
 #include <msp430.h>
 #include "i2c_master.h"
+#include "clock.h"
+#include "trace.h"
 #include <stdint.h>
 
+#define I2C_SDA BIT2                        // P1.2
+#define I2C_SCL BIT3                        // P1.3
+#define I2C_BUSY 0xFF                       // xfer_status while in flight
+#define I2C_TIMEOUT_TICKS ((uint16_t)(TRACE_TICK_HZ * I2C_TIMEOUT_US / 1000000UL))
+#define I2C_HALF_BIT_US (500000UL / I2C_BUS_HZ)
+
 volatile int i2c_busy = 0;
 
+static volatile uint8_t xfer_status = I2C_OK;
+static volatile uint8_t tx_byte;
+static volatile uint8_t tx_pending = 0;
+
 void i2c_master_setup(void) {
     //-- eUSCI_B0 --
     UCB0CTLW0 |= UCSWRST;
 
     UCB0CTLW0 |= UCSSEL__SMCLK;              // SMCLK
-    UCB0BRW = 10;                       // Divider
+    UCB0BRW = SMCLK_HZ / I2C_BUS_HZ;    // Divider
 
     UCB0CTLW0 |= UCMODE_3;              // I2C Mode
     UCB0CTLW0 |= UCMST;                 // Master
     UCB0CTLW0 |= UCTR;                  // Tx
-    UCB0CTLW1 |= UCASTP_2;
+    UCB0CTLW1 |= UCASTP_2;              // Automatic STOP after UCB0TBCNT bytes
+    UCB0TBCNT = 1;                      // Only writable in reset
     //-- Configure GPIO --------
     P1SEL1 &= ~BIT3;           // eUSCI_B0
     P1SEL0 |= BIT3;
@@ -23,30 +47,138 @@ void i2c_master_setup(void) {
     P1SEL1 &= ~BIT2;
     P1SEL0 |= BIT2;
 
-    
+    trace_timer_start();                // Transfer deadlines are timed on it
 }
 
- 
-
- void i2c_write_led(int pattNum) {
-    while(i2c_busy);
-    i2c_busy = 1;
-
-    UCB0CTLW0 |= UCTR;  // Transmit mode
-    UCB0I2CSA = 0x40;   // Slave address
+/**
+ * Take the module out of reset and enable its interrupts. Call once the
+ * GPIO lock is released, and after any reset; UCSWRST clears UCB0IE.
+ */
+void i2c_master_start(void) {
+    UCB0CTLW0 |= UCMST | UCTR;          // Arbitration loss drops to slave mode
+    UCB0CTLW0 &= ~UCSWRST;
+    UCB0IE |= UCTXIE0 | UCNACKIE | UCSTPIE | UCALIE;
+}
 
-    UCB0TBCNT = 1;
+/**
+ * Abandon whatever the module is doing. A STOP the ISR asked for after a
+ * NACK is let out first, until the transfer's deadline: a reset
+ * mid-STOP leaves the slave holding the bus.
+ *
+ * @param: start TRACE_TIMER when the transfer began.
+ */
+static void i2c_abort(uint16_t start) {
+    while ((UCB0CTLW0 & UCTXSTP) && (uint16_t)(TRACE_TIMER - start) <= I2C_TIMEOUT_TICKS) ;
+    UCB0CTLW0 |= UCSWRST;
+    tx_pending = 0;
+    i2c_master_start();
+}
 
-    UCB0IFG &= ~UCSTPIFG;
+/**
+ * Write one byte to a slave and wait, at most I2C_TIMEOUT_US, for it to
+ * finish.
+ *
+ * @param: addr 7-bit slave address.
+ * @param: byte Data byte.
+ *
+ * @return: I2C_OK, I2C_NACK, I2C_ARB_LOST or I2C_TIMEOUT.
+ */
+uint8_t i2c_xfer_write(uint8_t addr, uint8_t byte) {
+    uint16_t start;
+    uint8_t status;
 
-    send_buff = pattNum;
-    UCB0TXBUF = send_buff;
+    i2c_busy = 1;
+    UCB0I2CSA = addr;
+    tx_byte = byte;
+    tx_pending = 1;
+    xfer_status = I2C_BUSY;
+    UCB0IFG &= ~(UCSTPIFG | UCNACKIFG | UCALIFG);
+
+    TRACE(TRACE_EV_I2C_START, byte);
+    start = TRACE_TIMER;
+    UCB0CTLW0 |= UCTR | UCTXSTT;        // The ISR loads the byte on TXIFG0
+
+    while (xfer_status == I2C_BUSY) {
+        if ((uint16_t)(TRACE_TIMER - start) > I2C_TIMEOUT_TICKS) {
+            unsigned short sr = __get_interrupt_state();
+            __disable_interrupt();
+            if (xfer_status == I2C_BUSY) xfer_status = I2C_TIMEOUT;
+            __set_interrupt_state(sr);
+        }
+    }
+
+    status = xfer_status;
+    if (status != I2C_OK) i2c_abort(start);
+    i2c_busy = 0;
+    return status;
+}
 
-    UCB0CTLW0 |= UCTXSTT;
+/**
+ * True while a slave holds SDA low; the pin reads back whatever its
+ * function select.
+ */
+uint8_t i2c_sda_low(void) {
+    return !(P1IN & I2C_SDA);
+}
 
-    UCB0IFG &= ~UCSTPIFG;
+/**
+ * Free a bus whose slave is stuck mid-byte holding SDA low: take the pins
+ * as GPIO, clock SCL until the slave lets go (at most 9 pulses), then
+ * send a STOP. Lines are only ever pulled low or released, never driven
+ * high.
+ *
+ * @return: 1 if SDA is high afterwards.
+ */
+uint8_t i2c_bus_recover(void) {
+    uint8_t i, released;
 
-    i2c_busy = 0;
+    UCB0CTLW0 |= UCSWRST;
+    P1OUT &= ~(I2C_SDA | I2C_SCL);
+    P1DIR &= ~(I2C_SDA | I2C_SCL);              // Both released
+    P1SEL0 &= ~(I2C_SDA | I2C_SCL);
+
+    for (i = 0; i < 9 && !(P1IN & I2C_SDA); i++) {
+        P1DIR |= I2C_SCL;                       // SCL low
+        DELAY_US(I2C_HALF_BIT_US);
+        P1DIR &= ~I2C_SCL;                      // SCL high
+        DELAY_US(I2C_HALF_BIT_US);
+    }
+
+    P1DIR |= I2C_SDA;                           // SDA low while SCL high...
+    DELAY_US(I2C_HALF_BIT_US);
+    P1DIR &= ~I2C_SDA;                          // ...then high: STOP
+    DELAY_US(I2C_HALF_BIT_US);
+    released = (P1IN & I2C_SDA) != 0;
+
+    P1SEL0 |= I2C_SDA | I2C_SCL;
+    tx_pending = 0;
+    i2c_master_start();
+    TRACE(TRACE_EV_I2C_RECOVER, released);
+    return released;
+}
 
-} 
- 
+#pragma vector=EUSCI_B0_VECTOR
+__interrupt void EUSCI_B0_ISR(void){
+    switch (UCB0IV) {
+        case 0x02:  // ALIFG
+            xfer_status = I2C_ARB_LOST;
+            break;
+        case 0x04:  // NACKIFG
+            TRACE(TRACE_EV_I2C_NACK, 0);
+            UCB0CTLW0 |= UCTXSTP;   // Release the bus
+            xfer_status = I2C_NACK;
+            break;
+        case 0x08:  // STPIFG
+            TRACE(TRACE_EV_I2C_STOP, 0);
+            if (xfer_status == I2C_BUSY) xfer_status = I2C_OK;
+            break;
+        case 0x18:  // TXIFG0
+            if (tx_pending) {
+                UCB0TXBUF = tx_byte;
+                tx_pending = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
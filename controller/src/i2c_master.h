@@ -2,15 +2,28 @@
 #define I2C_MASTER_H
 
 #include <msp430.h>
+#include <stdint.h>
+
+#define I2C_BUS_HZ 100000UL                 // Standard-mode SCL
+#define I2C_TIMEOUT_US 2000UL               // Deadline for one transfer (~11 byte times)
+
+// Outcome of one transfer
+#define I2C_OK       0
+#define I2C_NACK     1
+#define I2C_ARB_LOST 2
+#define I2C_TIMEOUT  3
 
 
 void i2c_master_setup(void);
+void i2c_master_start(void);
+uint8_t i2c_xfer_write(uint8_t addr, uint8_t byte);
+uint8_t i2c_bus_recover(void);
+uint8_t i2c_sda_low(void);
 
 void update_LCD(int modeID, int temperature, int window_size);
-void i2c_write_led(int pattNum);
 void i2c_write_lcd(unsigned int pattNum, char character);
 volatile int send_buff;
 volatile int ready_to_send;
 extern volatile int i2c_busy;
 
-#endif
\ No newline at end of file
+#endif
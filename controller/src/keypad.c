@@ -3,6 +3,8 @@
 #include <stdbool.h>
 #include <msp430fr2355.h>
 #include "keypad.h"
+#include "clock.h"
+#include "cmd.h"
 
 char code[] = "5381";
 
@@ -33,13 +35,14 @@ char pressed_key() {
         P1OUT |= rowPins[row];                              // current row high
 
         for(col = 0; col < 4; col++) {                      // Check each column for high
-            __delay_cycles(1000);                       
+            DELAY_US(1000);
+            cmd_poll();                                     // A scan outlasts the RX ring
             if((P6IN & colPins[col]) != 0) {                // If column high
-                __delay_cycles(1000);                       // Debounce delay
+                DELAY_US(1000);                             // Debounce delay
                 if((P6IN & colPins[col]) != 0) {            // Check again
                 char keyP = keypad[row][col];
                 
-                while((P6IN & colPins[col]) != 0);          // Wait until key not pressed
+                while((P6IN & colPins[col]) != 0) cmd_poll(); // Wait until key not pressed
                 
                 return keyP;                                // Update key
                 }
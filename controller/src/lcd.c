@@ -2,6 +2,9 @@
 #include <msp430fr2355.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "clock.h"
+#include "cmd.h"
+#include "trace.h"
 
 volatile char button_pressed = ' ';
 volatile int curr_pattern = -1;
@@ -12,6 +15,15 @@ int blink = 0;
 volatile char last_pressed;
 volatile int last_pattern;
 
+// Wait ms milliseconds, serving the UART each one: a screen redraw takes
+// about a second, far longer than the RX ring lasts at UART_BAUD
+static void lcd_wait_ms(uint16_t ms) {
+    while (ms--) {
+        DELAY_US(1000);
+        cmd_poll();
+    }
+}
+
 void lcd_raw_send(int send_data, int num) {
     int send_data_temp = send_data;
     int nibble, i = 0;
@@ -35,11 +47,11 @@ void lcd_raw_send(int send_data, int num) {
         P2OUT = (P2OUT & ~(BIT0|BIT1|BIT2|BIT4)) | out;
 
         // pulse enable
-        P4OUT |= BIT7; _delay_cycles(1000);
-        P4OUT &= ~BIT7; _delay_cycles(1000);
+        P4OUT |= BIT7; DELAY_US(1000);
+        P4OUT &= ~BIT7; DELAY_US(1000);
         i++;
     }
-    _delay_cycles(50000);
+    lcd_wait_ms(50);
 }
 
 void lcd_string_write(char* string) {
@@ -75,7 +87,7 @@ void lcd_clear(void) {
     P4OUT &= ~BIT4; // RS=0
     P4OUT &= ~BIT6; // RW=0
     lcd_raw_send(0x01, 2);
-    __delay_cycles(200000);
+    lcd_wait_ms(200);
 }
 
 void lcd_set_cursor(uint8_t row, uint8_t col) {
@@ -92,7 +104,9 @@ void lcd_putc(char c) {
 }
 
 void lcd_puts(const char* s) {
-    while (*s) lcd_putc(*s++);
+    uint8_t n = 0;
+    while (s[n]) lcd_putc(s[n++]);
+    TRACE(TRACE_EV_LCD_FLUSH, n);
 }
 
 void setup_lcd() {
@@ -27,4 +27,7 @@ void lcd_set_cursor(uint8_t row, uint8_t col);
 void lcd_putc(char c);
 void lcd_puts(const char *str);
 
+#define LCD_COLS     16
+#define LCD_LINE_BUF 32     // One row plus room for fmt_* overflow
+
 #endif // LCD_H
\ No newline at end of file
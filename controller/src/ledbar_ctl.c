@@ -0,0 +1,38 @@
+#include "i2c_bus.h"
+#include "ledbar_ctl.h"
+
+// Show |pct| on the slave's LED bar, one bar per percent.
+void set_ledbar_percent(float pct) {
+    if (pct < 0.0f) pct = -pct;
+    if (pct > 100.0f) pct = 100.0f;
+     
+    int bars = pct;         
+    if (pct > 0.0f && bars == 0) // make sure ANY non‑zero percent lights at least 1
+        bars = 1;
+    if (bars > 8)                // cap at 8 bars
+        bars = 8;
+
+    int mask = 0;
+    if (bars > 0) {
+        mask = (int)(((1u << bars) -1 ) << (8 - bars));
+    }
+    i2c_write_led(mask);
+}
+
+// Show a raw pattern on the slave's LED bar, bit 7 leftmost.
+void set_ledbar_mask(uint8_t mask) {
+    i2c_write_led(mask);
+}
+
+// Show a z-score, one bar per half standard deviation: filling from the
+// left when the market is rich (z > 0), from the right when it is cheap.
+// The signal threshold of 2 sits at the middle of the bar.
+void set_ledbar_zscore(float z) {
+    int bars = (z < 0.0f ? -z : z) * 2.0f;
+    uint8_t mask;
+
+    if (bars > 8) bars = 8;
+    mask = (uint8_t)((1u << bars) - 1);
+    if (z > 0.0f) mask = (uint8_t)(mask << (8 - bars));
+    i2c_write_led(mask);
+}
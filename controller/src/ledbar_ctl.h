@@ -0,0 +1,10 @@
+#ifndef LEDBAR_CTL_H
+#define LEDBAR_CTL_H
+
+#include <stdint.h>
+
+void set_ledbar_percent(float pct);
+void set_ledbar_mask(uint8_t mask);
+void set_ledbar_zscore(float z);
+
+#endif // LEDBAR_CTL_H
@@ -0,0 +1,28 @@
+/**
+ * @file
+ * @brief Limits of the parameter editor: encoder step sizes and each
+ * parameter's range. Shared with tools/check/fmt_check.c, which sweeps
+ * every value the editor can reach.
+ */
+#include "param_edit.h"
+#include "params.h"
+
+const float step_values[NUM_STEPS] = {10.0f, 1.0f, 0.1f, 0.01f};
+
+/**
+ * Largest value the editor allows; the smallest is 0.
+ *
+ * @param: param Parameter ID.
+ */
+float range_for(int param) {
+    switch (param) {
+      case PARAM_STOCK_PRICE:
+      case PARAM_STRIKE_PRICE:  return 1000.0f;
+      case PARAM_TIME_EXP:      return   2.0f;
+      case PARAM_VOLATILITY:    return   1.0f;
+      case PARAM_RISK_FREE:     return   0.10f;
+      case PARAM_MKT_PRICE:     return   100.0f;
+      case PARAM_DIV_YIELD:     return   0.10f;
+      default:                  return   1.0f;
+    }
+}
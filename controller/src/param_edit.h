@@ -0,0 +1,10 @@
+#ifndef PARAM_EDIT_H
+#define PARAM_EDIT_H
+
+#define NUM_STEPS 4                         // Encoder step sizes
+
+extern const float step_values[NUM_STEPS];
+
+float range_for(int param);
+
+#endif // PARAM_EDIT_H
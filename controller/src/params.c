@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Option parameters shared between the UI and the pricer.
+ *
+ * Writers bump a sequence counter before and after touching the fields
+ * (odd = write in progress). Readers copy the fields and retry if the
+ * counter was odd or changed underneath them, so the pricer always runs
+ * on a consistent set without masking interrupts. Only one writer may be
+ * active at a time.
+ */
+#include "params.h"
+
+static volatile uint16_t params_seq = 0;
+static volatile struct option_params params = {
+    85.43f,     // stock_price
+    105.0f,     // strike_price
+    0.12f,      // time_to_exp
+    0.45f,      // volatility
+    0.05f,      // risk_free_rate
+    0.65f,      // market_price
+    0.0f,       // dividend_yield
+};
+
+void params_set(int param, float value) {
+    params_seq++;                                           // odd: write in progress
+    switch (param) {
+        case PARAM_STOCK_PRICE:  params.stock_price    = value; break;
+        case PARAM_STRIKE_PRICE: params.strike_price   = value; break;
+        case PARAM_TIME_EXP:     params.time_to_exp    = value; break;
+        case PARAM_VOLATILITY:   params.volatility     = value; break;
+        case PARAM_RISK_FREE:    params.risk_free_rate = value; break;
+        case PARAM_MKT_PRICE:    params.market_price   = value; break;
+        case PARAM_DIV_YIELD:    params.dividend_yield = value; break;
+        default: break;
+    }
+    params_seq++;                                           // even: stable again
+}
+
+float params_get(int param) {
+    struct option_params p;
+    params_snapshot(&p);
+    switch (param) {
+        case PARAM_STOCK_PRICE:  return p.stock_price;
+        case PARAM_STRIKE_PRICE: return p.strike_price;
+        case PARAM_TIME_EXP:     return p.time_to_exp;
+        case PARAM_VOLATILITY:   return p.volatility;
+        case PARAM_RISK_FREE:    return p.risk_free_rate;
+        case PARAM_MKT_PRICE:    return p.market_price;
+        case PARAM_DIV_YIELD:    return p.dividend_yield;
+        default:                 return 0.0f;
+    }
+}
+
+/**
+ * Copy a consistent set of parameters.
+ *
+ * @param: out Receives the parameters.
+ *
+ * @return: Times a write got in the way and the copy was redone, at most
+ *          255.
+ */
+uint8_t params_snapshot(struct option_params *out) {
+    uint16_t seq;
+    uint8_t retries = 0;
+    for (;;) {
+        seq = params_seq;
+        out->stock_price    = params.stock_price;
+        out->strike_price   = params.strike_price;
+        out->time_to_exp    = params.time_to_exp;
+        out->volatility     = params.volatility;
+        out->risk_free_rate = params.risk_free_rate;
+        out->market_price   = params.market_price;
+        out->dividend_yield = params.dividend_yield;
+        if (!(seq & 1) && seq == params_seq) return retries;
+        if (retries < 0xFF) retries++;
+    }
+}
+
+void params_restore(const struct option_params *in) {
+    params_seq++;
+    params.stock_price    = in->stock_price;
+    params.strike_price   = in->strike_price;
+    params.time_to_exp    = in->time_to_exp;
+    params.volatility     = in->volatility;
+    params.risk_free_rate = in->risk_free_rate;
+    params.market_price   = in->market_price;
+    params.dividend_yield = in->dividend_yield;
+    params_seq++;
+}
+
+// Changes on every write, so cached results can tell if they are stale.
+uint16_t params_version(void) {
+    return params_seq;
+}
@@ -0,0 +1,35 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+
+// Parameter IDs
+#define PARAM_STOCK_PRICE  1
+#define PARAM_STRIKE_PRICE 2
+#define PARAM_TIME_EXP     3
+#define PARAM_VOLATILITY   4
+#define PARAM_RISK_FREE    5
+#define PARAM_MKT_PRICE    6
+#define PARAM_DIV_YIELD    7
+#define PARAM_COUNT        7
+
+/**
+ * The Black-Scholes inputs for the contract being priced.
+ */
+struct option_params {
+    float stock_price;
+    float strike_price;
+    float time_to_exp;
+    float volatility;
+    float risk_free_rate;
+    float market_price;
+    float dividend_yield;   // Continuous, per year
+};
+
+void  params_set(int param, float value);
+float params_get(int param);
+uint8_t params_snapshot(struct option_params *out);
+void  params_restore(const struct option_params *in);
+uint16_t params_version(void);
+
+#endif // PARAMS_H
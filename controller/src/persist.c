@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief Versioned, checksummed parameter/result record in FRAM.
+ *
+ * The record lives in .TI.persistent, which the linker places below the
+ * write-protected program FRAM. persist_save() is only called when the
+ * user confirms a value, so FRAM sees one write per confirm.
+ */
+#include <msp430.h>
+#include <stddef.h>
+#include "persist.h"
+
+#pragma PERSISTENT(fram_record)
+static struct persist_record fram_record = {0};
+
+static uint16_t fletcher16(const uint8_t *data, uint16_t len) {
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    while (len--) {
+        sum1 += *data++;
+        if (sum1 >= 255) sum1 -= 255;
+        sum2 += sum1;
+        if (sum2 >= 255) sum2 -= 255;
+    }
+    return (sum2 << 8) | sum1;
+}
+
+/**
+ * Lift write protection on program FRAM, where .TI.persistent lives.
+ *
+ * @return: Previous SYSCFG0 setting, to hand back to fram_lock().
+ */
+uint16_t fram_unlock(void) {
+    uint16_t cfg = SYSCFG0 & 0xFF;
+    SYSCFG0 = FRWPPW | (cfg & ~PFWP);
+    return cfg;
+}
+
+void fram_lock(uint16_t cfg) {
+    SYSCFG0 = FRWPPW | cfg;
+}
+
+/**
+ * Restore the last confirmed parameters and result.
+ *
+ * @param: params Receives the stored parameters.
+ * @param: result Receives the stored result.
+ * @param: smile  Receives whether the result was priced in smile mode.
+ *
+ * @return: 1 if the record was valid and copied out, 0 otherwise.
+ */
+int persist_load(struct option_params *params, struct bs_result *result, uint8_t *smile) {
+    if (fram_record.magic != PERSIST_MAGIC || fram_record.version != PERSIST_VERSION) {
+        return 0;
+    }
+    if (fletcher16((const uint8_t *)&fram_record, offsetof(struct persist_record, checksum))
+            != fram_record.checksum) {
+        return 0;
+    }
+    *params = fram_record.params;
+    *result = fram_record.result;
+    *smile  = fram_record.smile;
+    return 1;
+}
+
+/**
+ * Write the record to FRAM.
+ *
+ * The checksum is written last, so a reset mid-write leaves a record that
+ * fails validation instead of one that restores half-updated values.
+ *
+ * @param: params Confirmed parameters, not the copy volsurf_apply() changed.
+ * @param: result Result priced from params.
+ * @param: smile  Whether result was priced in smile mode.
+ */
+void persist_save(const struct option_params *params, const struct bs_result *result,
+                  uint8_t smile) {
+    uint16_t cfg = fram_unlock();
+
+    fram_record.checksum = 0;
+    fram_record.magic    = PERSIST_MAGIC;
+    fram_record.version  = PERSIST_VERSION;
+    fram_record.params   = *params;
+    fram_record.result   = *result;
+    fram_record.smile    = smile;
+    fram_record.checksum = fletcher16((const uint8_t *)&fram_record,
+                                      offsetof(struct persist_record, checksum));
+
+    fram_lock(cfg);
+}
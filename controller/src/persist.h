@@ -0,0 +1,32 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdint.h>
+#include "params.h"
+#include "black_scholes.h"
+
+#define PERSIST_MAGIC   0x4253      // "BS"
+#define PERSIST_VERSION 4           // Bump when struct persist_record changes
+
+/**
+ * Everything restored on boot: the confirmed parameters, as entered, and
+ * the result priced from them. smile records whether that result used the
+ * vol surface in place of params.volatility.
+ */
+struct persist_record {
+    uint16_t magic;
+    uint16_t version;
+    struct option_params params;
+    struct bs_result result;
+    uint8_t smile;
+    uint16_t checksum;              // Fletcher-16 over all preceding bytes
+};
+
+uint16_t fram_unlock(void);
+void     fram_lock(uint16_t cfg);
+
+int  persist_load(struct option_params *params, struct bs_result *result, uint8_t *smile);
+void persist_save(const struct option_params *params, const struct bs_result *result,
+                  uint8_t smile);
+
+#endif // PERSIST_H
@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @brief Cached result for the current parameters, shared by the UI and
+ * the UART command interface.
+ */
+#include "pricer.h"
+#include "trace.h"
+#include "stats.h"
+#include "volsurf.h"
+
+struct bs_result last_result;               // Result for pricing version last_result_version
+static uint16_t last_result_version = 1;    // Odd: matches no stable version
+
+// Parameters and vol surface together; both versions are even
+static uint16_t pricing_version(void) {
+    return params_version() + volsurf_version();
+}
+
+/**
+ * Make last_result match the current parameters.
+ *
+ * Prices a consistent snapshot with interrupts enabled; skipped when the
+ * cached result was already computed from these parameters and vol
+ * surface. Each new result is recorded in the deviation statistics.
+ *
+ * @param: p Receives the parameters the result belongs to, with the
+ *           surface's vol in smile mode.
+ */
+void reprice(struct option_params *p) {
+    uint16_t version = pricing_version();
+    uint8_t retries;
+
+    TRACE(TRACE_EV_SNAP_START, 0);          // Interrupts stay enabled throughout
+    retries = params_snapshot(p);
+    TRACE(TRACE_EV_SNAP_END, retries);
+    volsurf_apply(p);
+    if (version != last_result_version) {
+        TRACE(TRACE_EV_PRICE_START, 0);
+        bs_price(p, &last_result);
+        TRACE(TRACE_EV_PRICE_END, 0);
+        last_result_version = version;
+        stats_add(last_result.call, p->market_price, last_result.pct_diff);
+    }
+}
+
+/**
+ * Adopt a previously computed result for the current parameters, e.g. one
+ * restored from FRAM after params_restore().
+ */
+void pricer_restore(const struct bs_result *res) {
+    last_result = *res;
+    last_result_version = pricing_version();
+}
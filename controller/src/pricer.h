@@ -0,0 +1,12 @@
+#ifndef PRICER_H
+#define PRICER_H
+
+#include "params.h"
+#include "black_scholes.h"
+
+extern struct bs_result last_result;
+
+void reprice(struct option_params *p);
+void pricer_restore(const struct bs_result *res);
+
+#endif // PRICER_H
@@ -1,58 +1,105 @@
+/**
+ * @file
+ * @brief Rotary encoder on P3.4 (A) and P3.5 (B).
+ *
+ * Two decoders share one quadrature table. The default takes a PORT3
+ * interrupt on every edge. With ENCODER_SAMPLED, TB2 samples both pins
+ * at ENC_SAMPLE_HZ and a new state only counts once ENC_FILTER samples
+ * in a row agree on it. Bounce pulses shorter than that never form a
+ * state, and the ISR rate is fixed however fast the knob turns or the
+ * contacts chatter.
+ */
 #include <msp430.h>
-#include "../src/keypad.h"
-#include "../src/i2c_master.h"
-#include "../src/lcd.h"
-#include <string.h>
+#include "rotary.h"
+#include "clock.h"
 #include <stdint.h>
 
-// --- Rotary encoder driver (on P5.0/A, P5.1/B)
+#define ENC_PINS (BIT4 | BIT5)
+
+// Count change for (previous state << 2) | new state. Both lines changing
+// at once is a missed state and counts 0.
+static const int8_t enc_step[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0,
+};
+
 static volatile int16_t count = 0;
-static volatile uint8_t last  = 0;
+static volatile uint8_t last  = 0;          // Last state counted, B:A
+
+#if ENCODER_SAMPLED
+static uint8_t candidate = 0;               // State being filtered
+static uint8_t stable = 0;                  // Samples it has held
+#endif
 
 void setup_encoder(void) {
     // P3.4/P3.5 are GPIO
-    P3SEL0 &= ~(BIT4|BIT5);
-    P3SEL1 &= ~(BIT4|BIT5);
+    P3SEL0 &= ~ENC_PINS;
+    P3SEL1 &= ~ENC_PINS;
     // Inputs with pull‑ups
-    P3DIR   &= ~(BIT4|BIT5);
-    P3REN   |=  (BIT4|BIT5);
-    P3OUT   |=  (BIT4|BIT5);
-    // Enable interrupts on both edges
-    P3IES   &= ~(BIT4|BIT5);
-    P3IE    |=  (BIT4|BIT5);
-    P3IFG   &= ~(BIT4|BIT5);
+    P3DIR   &= ~ENC_PINS;
+    P3REN   |=  ENC_PINS;
+    P3OUT   |=  ENC_PINS;
     // Read initial state
     last = (P3IN >> 4) & 0x03;
+#if ENCODER_SAMPLED
+    candidate = last;
+    stable = ENC_FILTER;
+    TB2CCR0 = ACLK_HZ / ENC_SAMPLE_HZ - 1;
+    TB2CCTL0 = CCIE;
+    TB2CTL = TBSSEL__ACLK | MC__UP | TBCLR;
+#else
+    // Interrupt on the edge away from the current level of each pin
+    P3IES   = (P3IES & ~ENC_PINS) | (P3IN & ENC_PINS);
+    P3IFG   &= ~ENC_PINS;
+    P3IE    |=  ENC_PINS;
+#endif
 }
 
+/**
+ * Counts since the last call. Read and cleared with interrupts off so
+ * none landing in between are lost.
+ */
 int16_t encoder_get_delta(void) {
+    unsigned short sr = __get_interrupt_state();
+    __disable_interrupt();
     int16_t d = count;
     count = 0;
+    __set_interrupt_state(sr);
     return d;
 }
 
+#if ENCODER_SAMPLED
+
+#pragma vector=TIMER2_B0_VECTOR
+__interrupt void Timer_B2_ISR(void) {
+    uint8_t s = (P3IN >> 4) & 0x03;
+
+    if (s != candidate) {
+        candidate = s;
+        stable = 0;
+    }
+    if (stable < ENC_FILTER && ++stable == ENC_FILTER) {
+        count += enc_step[(last << 2) | s];
+        last = s;
+    }
+}
+
+#else
+
 #pragma vector=PORT3_VECTOR
 __interrupt void PORT3_ISR(void) {
-    // Debug LED toggle
-    P1OUT ^= BIT0;
-
-    uint8_t triggered = P3IFG & (BIT4|BIT5);
+    uint8_t triggered = P3IFG & ENC_PINS;
     if (!triggered) return;
     P3IFG &= ~triggered;
 
-    uint8_t s   = (P3IN >> 4) & 0x03;
-    uint8_t idx = (last << 2) | s;
-    switch (idx) {
-      case 0b0001: case 0b0111:
-      case 0b1110: case 0b1000:
-        count++; break;
-      case 0b0010: case 0b1011:
-      case 0b1101: case 0b0100:
-        count--; break;
-      default: break;
-    }
+    uint8_t s = (P3IN >> 4) & 0x03;
+    count += enc_step[(last << 2) | s];
     last = s;
 
     if (triggered & BIT4) P3IES ^= BIT4;
     if (triggered & BIT5) P3IES ^= BIT5;
 }
+
+#endif
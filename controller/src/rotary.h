@@ -3,6 +3,17 @@
 
 #include <stdint.h>
 
+#ifndef ENCODER_SAMPLED
+#define ENCODER_SAMPLED 0                   // 1: poll the encoder from TB2 instead of edge interrupts
+#endif
+
+#ifndef ENC_SAMPLE_HZ
+#define ENC_SAMPLE_HZ 4096                  // TB2 rate when sampled; divides ACLK_HZ
+#endif
+#ifndef ENC_FILTER
+#define ENC_FILTER    2                     // Equal samples in a row before a state counts (~0.5 ms)
+#endif
+
 void setup_encoder(void);
 int16_t encoder_get_delta(void);
 
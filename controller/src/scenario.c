@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @brief Spot-shock sweep of the current contract.
+ *
+ * Only S, S e^-qT and ln(S) change between scenarios. The sweep prepares
+ * the contract once, takes ln(K) once, and shifts ln(S) by the tabulated
+ * ln(1 + shock), so each scenario costs two normal CDFs and no other
+ * transcendental. The vol is held at the one the contract was priced
+ * with (sticky strike).
+ */
+#include <math.h>
+#include "scenario.h"
+#include "black_scholes.h"
+
+static const float shock[SCEN_COUNT] = {
+    0.92f, 0.94f, 0.96f, 0.98f, 1.02f, 1.04f, 1.06f, 1.08f,
+};
+
+static const float ln_shock[SCEN_COUNT] = {        // ln(shock[i])
+    -0.083381609f, -0.061875404f, -0.040821995f, -0.020202707f,
+     0.019802627f,  0.039220713f,  0.058268908f,  0.076961041f,
+};
+
+/**
+ * Price every scenario.
+ *
+ * @param: s Receives the shocked spots and their call prices.
+ * @param: p Contract; stock_price is the centre of the sweep.
+ */
+void scenario_price(struct scenario *s, const struct option_params *p) {
+    struct bs_shared base, sh;
+    struct bs_terms t;
+    float K = p->strike_price;
+    float ln_k = (K > 0.0f) ? logf(K) : 0.0f;
+    uint8_t i;
+
+    bs_prepare(&base, p->stock_price, p->time_to_exp, p->risk_free_rate,
+               p->dividend_yield, p->volatility);
+    for (i = 0; i < SCEN_COUNT; i++) {
+        bs_shift_spot(&sh, &base, shock[i], ln_shock[i]);
+        s->spot[i] = sh.stock_price;
+        s->call[i] = bs_call_ln_k(&sh, K, ln_k, &t);
+    }
+}
+
+/**
+ * LED bar mask of the scenarios in which the market price is rich, i.e.
+ * above the model. Calls rise with spot, so a lit run from the left ends
+ * where the market price stops being rich.
+ *
+ * @return: Bit 7 = lowest spot.
+ */
+uint8_t scenario_rich_mask(const struct scenario *s, float market_price) {
+    uint8_t mask = 0;
+    uint8_t i;
+    for (i = 0; i < SCEN_COUNT; i++) {
+        if (market_price > s->call[i]) mask |= 0x80 >> i;
+    }
+    return mask;
+}
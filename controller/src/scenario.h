@@ -0,0 +1,21 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdint.h>
+#include "params.h"
+
+#define SCEN_COUNT 8                        // One per LED
+
+/**
+ * The contract repriced at spot shocks of -8%, -6%, -4%, -2%, +2%, +4%,
+ * +6% and +8%, lowest spot first.
+ */
+struct scenario {
+    float spot[SCEN_COUNT];
+    float call[SCEN_COUNT];
+};
+
+void    scenario_price(struct scenario *s, const struct option_params *p);
+uint8_t scenario_rich_mask(const struct scenario *s, float market_price);
+
+#endif // SCENARIO_H
@@ -0,0 +1,130 @@
+/**
+ * @file
+ * @brief Running statistics of the market's deviation from the model.
+ *
+ * Every priced quote goes into a ring of STATS_DEPTH samples. The window
+ * keeps exact integer sums of the deviations and their squares, quantized
+ * to 1/STATS_DEV_SCALE percent, so adding a sample and dropping the one
+ * the ring overwrites are a few integer operations and never leave
+ * rounding behind. The mean and variance are formed from the sums only
+ * when a summary is asked for.
+ */
+#include <math.h>
+#include "stats.h"
+#include "clock.h"
+
+#define STATS_DEV_SCALE 1000                // Window sums count thousandths of a percent
+#define STATS_DEV_LIMIT 50000.0f            // |dev| clamp, keeps n * sum of squares within int64
+
+static struct stats_sample ring[STATS_DEPTH];
+static uint8_t head = 0;                    // Next slot to write
+static uint8_t count = 0;
+static uint16_t added = 0;
+static int64_t sum = 0;                     // Of quantized deviations in the window
+static int64_t sum_sq = 0;                  // Of their squares
+static float ewma = 0.0f;
+static float min_dev = 0.0f;
+static float max_dev = 0.0f;
+
+// Deviation in window units, rounded half away from zero
+static int32_t quantize(float dev) {
+    if (dev > STATS_DEV_LIMIT) dev = STATS_DEV_LIMIT;
+    if (dev < -STATS_DEV_LIMIT) dev = -STATS_DEV_LIMIT;
+    float s = dev * STATS_DEV_SCALE;
+    return (int32_t)(s < 0.0f ? s - 0.5f : s + 0.5f);
+}
+
+void stats_reset(void) {
+    head = 0;
+    count = 0;
+    added = 0;
+    sum = 0;
+    sum_sq = 0;
+    ewma = 0.0f;
+    min_dev = 0.0f;
+    max_dev = 0.0f;
+}
+
+/**
+ * Record a priced quote.
+ *
+ * @param: model  Model price.
+ * @param: market Market price.
+ * @param: dev    Deviation of market from model, percent.
+ */
+void stats_add(float model, float market, float dev) {
+    struct stats_sample *s = &ring[head];
+
+    if (count == 0) {
+        ewma = min_dev = max_dev = dev;
+    } else {
+        ewma += STATS_EWMA_ALPHA * (dev - ewma);
+        if (dev < min_dev) min_dev = dev;
+        if (dev > max_dev) max_dev = dev;
+    }
+
+    if (count < STATS_DEPTH) {
+        count++;
+    } else {
+        int32_t old = quantize(s->dev);     // Oldest sample, about to be overwritten
+        sum -= old;
+        sum_sq -= (int64_t)old * old;
+    }
+    int32_t q = quantize(dev);
+    sum += q;
+    sum_sq += (int64_t)q * q;
+
+    s->model = model;
+    s->market = market;
+    s->dev = dev;
+    s->time = uptime_s;
+    head = (head + 1) & (STATS_DEPTH - 1);
+    added++;
+}
+
+/**
+ * @param: age 0 for the newest sample.
+ *
+ * @return: The sample, or 0 if the window holds fewer than age + 1.
+ */
+const struct stats_sample *stats_sample(uint8_t age) {
+    if (age >= count) return 0;
+    return &ring[(head - 1 - age) & (STATS_DEPTH - 1)];
+}
+
+void stats_summary(struct stats_summary *out) {
+    out->count = count;
+    out->added = added;
+    out->mean = 0.0f;
+    out->stddev = 0.0f;
+    out->ewma = ewma;
+    out->min = min_dev;
+    out->max = max_dev;
+    out->z = 0.0f;
+    out->span = 0;
+    if (count > 0) {
+        const struct stats_sample *newest = stats_sample(0);
+        out->mean = (float)sum / ((float)count * STATS_DEV_SCALE);
+        if (count > 1) {
+            // n * m2, exact: n * sum_sq - sum^2 stays within int64 under the clamp
+            float n_m2 = (float)((int64_t)count * sum_sq - sum * sum);
+            out->stddev = sqrtf(n_m2 / ((float)count * (count - 1))) / STATS_DEV_SCALE;
+        }
+        if (out->stddev > 0.0f) out->z = (newest->dev - out->mean) / out->stddev;
+        out->span = newest->time - stats_sample(count - 1)->time;
+    }
+}
+
+/**
+ * Trading signal from the newest sample's z-score, so the threshold adapts
+ * to how noisy the deviation has recently been instead of being a fixed
+ * percentage.
+ *
+ * @return: STATS_SELL, STATS_BUY or STATS_HOLD.
+ */
+int8_t stats_signal(const struct stats_summary *s) {
+    if (s->count < 2) return STATS_HOLD;
+    if (s->z >=  STATS_Z_ENTRY) return STATS_SELL;
+    if (s->z <= -STATS_Z_ENTRY) return STATS_BUY;
+    return STATS_HOLD;
+}
@@ -0,0 +1,48 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+#define STATS_DEPTH      32                 // Samples in the window; power of two
+#define STATS_EWMA_ALPHA 0.125f             // Weight of the newest sample
+#define STATS_Z_ENTRY    2.0f               // |z| at which the signal fires
+
+#define STATS_HOLD  0
+#define STATS_SELL  1                       // Market rich against its recent deviation
+#define STATS_BUY   (-1)                    // Market cheap
+
+/**
+ * One priced quote.
+ */
+struct stats_sample {
+    float model;
+    float market;
+    float dev;                              // pct_diff, percent
+    uint16_t time;                          // uptime_s when recorded
+};
+
+/**
+ * Deviation statistics. Mean and standard deviation cover the window of
+ * the last STATS_DEPTH samples, with each deviation rounded to 0.001% and
+ * clamped to +-50000%; min, max and the EWMA cover everything since the
+ * last reset.
+ */
+struct stats_summary {
+    uint8_t count;                          // Samples in the window
+    float mean;
+    float stddev;
+    float ewma;
+    float min;
+    float max;
+    float z;                                // z-score of the newest sample
+    uint16_t span;                          // Seconds from oldest to newest sample
+    uint16_t added;                         // Samples recorded since reset, wrapping
+};
+
+void   stats_reset(void);
+void   stats_add(float model, float market, float dev);
+void   stats_summary(struct stats_summary *out);
+int8_t stats_signal(const struct stats_summary *s);
+const struct stats_sample *stats_sample(uint8_t age);
+
+#endif // STATS_H
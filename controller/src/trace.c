@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Binary event trace in a RAM ring buffer.
+ *
+ * Records are 4 bytes: a 16-bit timestamp from a free-running timer, an
+ * event ID and an 8-bit argument. Timer overflows are logged as WRAP
+ * records carrying a wrap counter, but only if something was traced since
+ * the previous one, so an idle board does not flush the buffer. The host
+ * decoder (tools/trace_decode.c) uses them to rebuild absolute time.
+ */
+#include <msp430.h>
+#include "trace.h"
+#include "uart.h"
+#include "clock.h"
+
+struct trace_rec trace_buf[TRACE_DEPTH];
+volatile uint8_t trace_head = 0;
+volatile uint8_t trace_on = 1;
+
+static uint8_t wrap_count = 0;
+static uint8_t head_at_wrap = 0;
+
+/**
+ * Start TRACE_TIMER free-running, unless it already is. The I2C driver
+ * times its deadlines on it, so i2c_master_setup() starts it too.
+ */
+void trace_timer_start(void) {
+    if ((TB3CTL & MC) != MC__STOP) return;
+    TB3EX0 = TBIDEX__8;                                                // SMCLK / 64
+    TB3CTL = TBSSEL__SMCLK | MC__CONTINUOUS | ID__8 | TBCLR;
+}
+
+void setup_trace(void) {
+    trace_timer_start();
+    TB3CTL |= TBIE;                                                    // Overflow interrupt
+}
+
+static void uart_put16(uint16_t v) {
+    uart_putc(v & 0xFF);
+    uart_putc(v >> 8);
+}
+
+/**
+ * Send the whole buffer over the UART, oldest record first.
+ *
+ * Frame: "TRC", board ID, tick rate (u32 LE), depth (u16 LE), then depth
+ * records. Unused slots have ID TRACE_EV_NONE. Tracing is paused while
+ * the frame is sent so it stays consistent.
+ */
+void trace_dump(void) {
+    uint16_t i;
+    uint32_t hz = TRACE_TICK_HZ;
+
+    trace_on = 0;
+    uint8_t h = trace_head;
+
+    uart_write("TRC", 3);
+    uart_putc(TRACE_BOARD);
+    uart_put16(hz & 0xFFFF);
+    uart_put16(hz >> 16);
+    uart_put16(TRACE_DEPTH);
+    for (i = 0; i < TRACE_DEPTH; i++) {
+        const struct trace_rec *r = &trace_buf[(h + i) & (TRACE_DEPTH - 1)];
+        uart_put16(r->ts);
+        uart_putc(r->id);
+        uart_putc(r->arg);
+    }
+    trace_on = 1;
+}
+
+#pragma vector=TIMER3_B1_VECTOR
+__interrupt void Timer_B3_Overflow_ISR(void) {
+    switch (__even_in_range(TB3IV, TBIV__TBIFG)) {
+        case TBIV__TBIFG:
+            wrap_count++;
+            if (trace_head != head_at_wrap) {
+                TRACE(TRACE_EV_WRAP, wrap_count);
+                head_at_wrap = trace_head;
+            }
+            break;
+        default:
+            break;
+    }
+}
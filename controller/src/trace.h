@@ -0,0 +1,67 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <msp430.h>
+#include <stdint.h>
+#include "clock.h"
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1                      // Set to 0 to compile all TRACE() calls out
+#endif
+
+#define TRACE_DEPTH   128                   // Records, power of 2
+#define TRACE_BOARD   'C'                   // Controller
+#define TRACE_TIMER   TB3R                  // Free-running SMCLK / 64
+#define TRACE_TICK_HZ (SMCLK_HZ / 64)       // Also the I2C driver's deadline clock
+
+// Event IDs, shared with i2c-led-bar/src/trace.h and tools/trace_decode.c
+#define TRACE_EV_NONE        0
+#define TRACE_EV_WRAP        1              // arg: timer wrap counter
+#define TRACE_EV_KEY         2              // arg: key character
+#define TRACE_EV_ENC         3              // arg: encoder delta (int8)
+#define TRACE_EV_PRICE_START 4              // arg: 0 contract, 1 chain, 2 tree, 3 watchlist, 4 scenarios
+#define TRACE_EV_PRICE_END   5
+#define TRACE_EV_I2C_START   6              // arg: data byte
+#define TRACE_EV_I2C_STOP    7
+#define TRACE_EV_I2C_NACK    8
+#define TRACE_EV_LCD_FLUSH   9              // arg: characters written
+#define TRACE_EV_I2C_RX      10             // arg: data byte
+#define TRACE_EV_LED_UPDATE  11             // arg: LED pattern
+#define TRACE_EV_I2C_ERR     12             // arg: I2C_NACK, I2C_ARB_LOST or I2C_TIMEOUT
+#define TRACE_EV_I2C_RECOVER 13             // arg: 1 if SDA was released
+#define TRACE_EV_SNAP_START  14             // reprice()'s params_snapshot()
+#define TRACE_EV_SNAP_END    15             // arg: retries
+
+struct trace_rec {
+    uint16_t ts;
+    uint8_t  id;
+    uint8_t  arg;
+};
+
+extern struct trace_rec trace_buf[TRACE_DEPTH];
+extern volatile uint8_t trace_head;
+extern volatile uint8_t trace_on;
+
+#if TRACE_ENABLE
+// Safe from ISRs and main; a handful of instructions per record.
+#define TRACE(ev, a) do {                                       \
+        unsigned short sr_ = __get_interrupt_state();           \
+        __disable_interrupt();                                  \
+        if (trace_on) {                                         \
+            uint8_t h_ = trace_head;                            \
+            trace_buf[h_].ts  = TRACE_TIMER;                    \
+            trace_buf[h_].id  = (ev);                           \
+            trace_buf[h_].arg = (uint8_t)(a);                   \
+            trace_head = (h_ + 1) & (TRACE_DEPTH - 1);          \
+        }                                                       \
+        __set_interrupt_state(sr_);                             \
+    } while (0)
+#else
+#define TRACE(ev, a) do { } while (0)
+#endif
+
+void setup_trace(void);
+void trace_timer_start(void);
+void trace_dump(void);
+
+#endif // TRACE_H
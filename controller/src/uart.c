@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief eUSCI_A1 UART on P4.2 (RXD) / P4.3 (TXD), the LaunchPad backchannel.
+ *
+ * RX is interrupt driven into a single-producer ring buffer; TX polls.
+ * Bytes that arrive while the ring is full are dropped, and UART_RX_GAP is
+ * queued in their place as soon as there is room, so the reader knows
+ * which line lost them.
+ */
+#include <msp430.h>
+#include "uart.h"
+#include "clock.h"
+
+#define UART_N (SMCLK_HZ / UART_BAUD)       // Clocks per bit
+
+static volatile uint8_t rx_buf[UART_RX_SIZE];
+static volatile uint8_t rx_head = 0;        // Written by the ISR
+static volatile uint8_t rx_tail = 0;        // Written by uart_getc()
+static uint8_t rx_dropped = 0;              // ISR only: a gap is waiting to be queued
+
+void setup_uart(void) {
+    UCA1CTLW0 |= UCSWRST;
+    UCA1CTLW0 |= UCSSEL__SMCLK;
+
+    // 16x oversampling; UCBRSx is left at 0, which is within 0.2% at 24 MHz
+    UCA1BRW = UART_N / 16;
+    UCA1MCTLW = UCOS16 | ((UART_N % 16) << 4);
+
+    P4SEL1 &= ~(BIT2 | BIT3);
+    P4SEL0 |= (BIT2 | BIT3);
+
+    UCA1CTLW0 &= ~UCSWRST;
+    UCA1IE |= UCRXIE;
+}
+
+void uart_putc(uint8_t c) {
+    while (!(UCA1IFG & UCTXIFG));
+    UCA1TXBUF = c;
+}
+
+void uart_write(const char *buf, uint16_t len) {
+    while (len--) uart_putc(*buf++);
+}
+
+void uart_puts(const char *str) {
+    while (*str) uart_putc(*str++);
+}
+
+/**
+ * Pop one received byte.
+ *
+ * @return: The byte, UART_RX_GAP where bytes were dropped, or -1 if
+ *          nothing is waiting.
+ */
+int uart_getc(void) {
+    if (rx_tail == rx_head) return -1;
+    uint8_t c = rx_buf[rx_tail];
+    rx_tail = (rx_tail + 1) & (UART_RX_SIZE - 1);
+    return c;
+}
+
+// Queue one byte from the ISR; 0 if the ring is full
+static uint8_t rx_put(uint8_t c) {
+    uint8_t next = (rx_head + 1) & (UART_RX_SIZE - 1);
+    if (next == rx_tail) return 0;
+    rx_buf[rx_head] = c;
+    rx_head = next;
+    return 1;
+}
+
+#pragma vector=EUSCI_A1_VECTOR
+__interrupt void EUSCI_A1_ISR(void) {
+    switch (__even_in_range(UCA1IV, USCI_UART_UCTXCPTIFG)) {
+        case USCI_UART_UCRXIFG: {
+            uint8_t c = UCA1RXBUF;
+            if (rx_dropped) {
+                if (!rx_put(UART_RX_GAP)) break;
+                rx_dropped = 0;
+            }
+            if (!rx_put(c)) rx_dropped = 1;
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+
+#define UART_BAUD    115200UL
+#define UART_RX_SIZE 256                    // RX ring buffer, power of 2, at most 256:
+                                            // four CMD_LINE_MAX lines in flight
+#define UART_RX_GAP  0xFF                   // Read where bytes were dropped; never valid input
+
+void setup_uart(void);
+void uart_putc(uint8_t c);
+void uart_write(const char *buf, uint16_t len);
+void uart_puts(const char *str);
+int  uart_getc(void);
+
+#endif // UART_H
@@ -0,0 +1,115 @@
+/**
+ * @file
+ * @brief Volatility smile over moneyness and expiry, in FRAM.
+ *
+ * The axes are uniform, so the cell holding a point is found by scaling
+ * with the precomputed reciprocal of the step instead of a search or a
+ * divide; the vol is then bilinear between the cell's four corners.
+ * Points outside the grid take the value at its edge.
+ */
+#include "volsurf.h"
+#include "persist.h"
+
+#define VOLS_INV_DM (1.0f / VOLS_DM)        // Folded by the compiler
+#define VOLS_INV_DT (1.0f / VOLS_DT)
+
+#pragma PERSISTENT(surface)
+static struct vol_surface surface = {
+    0,
+    {   //  K/S: 0.7     0.8     0.9     1.0     1.1     1.2     1.3
+        { 0.586f, 0.506f, 0.444f, 0.400f, 0.374f, 0.366f, 0.376f },     // T = 0.0
+        { 0.524f, 0.471f, 0.429f, 0.400f, 0.383f, 0.377f, 0.384f },     // T = 0.5
+        { 0.493f, 0.453f, 0.422f, 0.400f, 0.387f, 0.383f, 0.388f },     // T = 1.0
+        { 0.474f, 0.442f, 0.418f, 0.400f, 0.390f, 0.386f, 0.390f },     // T = 1.5
+        { 0.462f, 0.435f, 0.415f, 0.400f, 0.391f, 0.389f, 0.392f },     // T = 2.0
+    },
+};
+
+static uint16_t surface_version = 0;        // Steps by 2; see volsurf_version()
+static float inv_s_spot = 0.0f;             // Spot inv_s was computed for
+static float inv_s = 0.0f;
+
+// Split a coordinate into a cell index and the fraction across the cell
+static uint8_t locate(float pos, uint8_t points, float *frac) {
+    uint8_t i;
+    if (pos <= 0.0f) {
+        *frac = 0.0f;
+        return 0;
+    }
+    if (pos >= (float)(points - 1)) {
+        *frac = 1.0f;
+        return points - 2;
+    }
+    i = (uint8_t)pos;
+    *frac = pos - i;
+    return i;
+}
+
+/**
+ * Vol at a point of the grid.
+ *
+ * @param: moneyness K / S.
+ * @param: T         Time to expiry, years.
+ */
+float volsurf_vol(float moneyness, float T) {
+    float fm, ft;
+    uint8_t im = locate((moneyness - VOLS_M0) * VOLS_INV_DM, VOLS_NM, &fm);
+    uint8_t it = locate((T - VOLS_T0) * VOLS_INV_DT, VOLS_NT, &ft);
+    const float *lo = surface.vol[it];
+    const float *hi = surface.vol[it + 1];
+
+    float a = lo[im] + fm * (lo[im + 1] - lo[im]);
+    float b = hi[im] + fm * (hi[im + 1] - hi[im]);
+    return a + ft * (b - a);
+}
+
+/**
+ * In smile mode, replace p->volatility with the table's vol for p's
+ * strike, spot and expiry; otherwise leave p alone. Moneyness is K times
+ * 1 / S, as chain_price() scales it; the reciprocal is kept until the
+ * spot changes, so the watchlist's contracts and every reprice between
+ * two quotes share one divide.
+ */
+void volsurf_apply(struct option_params *p) {
+    if (surface.smile && p->stock_price > 0.0f) {
+        if (p->stock_price != inv_s_spot) {
+            inv_s_spot = p->stock_price;
+            inv_s = 1.0f / inv_s_spot;
+        }
+        p->volatility = volsurf_vol(p->strike_price * inv_s, p->time_to_exp);
+    }
+}
+
+/**
+ * Store one grid value.
+ *
+ * @param: cell Row-major index, expiry * VOLS_NM + moneyness.
+ * @param: vol  Implied volatility; ignored unless positive.
+ */
+void volsurf_set_cell(uint8_t cell, float vol) {
+    uint16_t cfg;
+    if (cell >= VOLS_CELLS || vol <= 0.0f) return;
+    cfg = fram_unlock();
+    surface.vol[cell / VOLS_NM][cell % VOLS_NM] = vol;
+    fram_lock(cfg);
+    surface_version += 2;
+}
+
+void volsurf_set_smile(uint8_t on) {
+    uint16_t cfg = fram_unlock();
+    surface.smile = on ? 1 : 0;
+    fram_lock(cfg);
+    surface_version += 2;
+}
+
+uint8_t volsurf_smile(void) {
+    return surface.smile;
+}
+
+/**
+ * Changes on every table write or mode switch. Always even, so it can be
+ * added to params_version() to key a cache on both.
+ */
+uint16_t volsurf_version(void) {
+    return surface_version;
+}
@@ -0,0 +1,32 @@
+#ifndef VOLSURF_H
+#define VOLSURF_H
+
+#include <stdint.h>
+#include "params.h"
+
+// Grid axes, fixed at build time: uniform steps make a lookup O(1)
+#define VOLS_NM   7                         // Moneyness K/S points
+#define VOLS_M0   0.70f
+#define VOLS_DM   0.10f
+#define VOLS_NT   5                         // Expiry points, years
+#define VOLS_T0   0.0f
+#define VOLS_DT   0.50f
+#define VOLS_CELLS (VOLS_NM * VOLS_NT)
+
+/**
+ * Implied volatility on the grid, row per expiry, and whether pricing
+ * uses it in place of the volatility parameter.
+ */
+struct vol_surface {
+    uint8_t smile;
+    float vol[VOLS_NT][VOLS_NM];
+};
+
+float    volsurf_vol(float moneyness, float T);
+void     volsurf_apply(struct option_params *p);
+void     volsurf_set_cell(uint8_t cell, float vol);
+void     volsurf_set_smile(uint8_t on);
+uint8_t  volsurf_smile(void);
+uint16_t volsurf_version(void);
+
+#endif // VOLSURF_H
@@ -0,0 +1,226 @@
+/**
+ * @file
+ * @brief Watchlist of contracts on one underlying, repriced in idle time.
+ *
+ * Contract inputs are a struct of arrays in FRAM; results and dirty bits
+ * are in RAM, so every contract is repriced once after reset. The
+ * selected contract is mirrored in the live parameters, which the UI and
+ * the UART edit. watch_idle() folds those edits back into its slot.
+ *
+ * A change to the underlying, rate or dividend yield marks every contract
+ * dirty. A strike, expiry or volatility change marks only its own
+ * contract. A market price change never reprices; the call it is compared
+ * against is still valid, so only the deviation is recomputed. Any change
+ * to the vol surface or smile mode marks every contract dirty.
+ *
+ * FRAM is only written when the selected contract's strike, expiry or
+ * volatility changes (a confirmed edit, or a UART set of K, T or V) and
+ * when the selection moves: at most once per such edit. Market quotes
+ * stay in RAM and reach FRAM with their slot's next write, so a stream of
+ * M quotes causes no FRAM writes at all.
+ */
+#include "watchlist.h"
+#include "black_scholes.h"
+#include "persist.h"
+#include "trace.h"
+#include "volsurf.h"
+
+#define WATCH_ALL ((uint8_t)((1u << WATCH_MAX) - 1))
+
+#pragma PERSISTENT(watch)
+static struct watch_contracts watch = {
+    WATCH_MAX,
+    0,
+    { 105.0f,  95.0f, 115.0f, 105.0f },     // strike_price; slot 0 matches the
+    {   0.12f,  0.12f,  0.12f,  0.37f },     // time_to_exp   default parameters
+    {   0.45f,  0.45f,  0.45f,  0.45f },     // volatility
+    {   0.65f,  2.40f,  0.15f,  3.50f },     // market_price
+};
+
+static float watch_call_price[WATCH_MAX];
+static float watch_pct[WATCH_MAX];
+static uint8_t watch_dirty = WATCH_ALL;
+static float live_market[WATCH_MAX];        // Quotes newer than FRAM's, per live_mask
+static uint8_t live_mask = 0;
+
+// Shared inputs the results were priced with
+static float seen_stock = -1.0f;
+static float seen_rate = -1.0f;
+static float seen_yield = -1.0f;
+static uint16_t seen_version = 1;           // Odd: matches no stable version
+static uint16_t seen_surface = 0;
+
+static float pct_diff(float market, float call) {
+    return (call > 0.0f) ? (market - call) / call * 100.0f : 0.0f;
+}
+
+// Write slot i's RAM quote into FRAM; the caller has unlocked it
+static void flush_market(uint8_t i) {
+    if (live_mask & (1u << i)) {
+        watch.market_price[i] = live_market[i];
+        live_mask &= ~(1u << i);
+    }
+}
+
+/**
+ * Copy the live parameters' contract fields into the selected slot and
+ * mark what they invalidate. Only strike, expiry or volatility changes
+ * are written to FRAM.
+ */
+static void sync_selected(const struct option_params *p) {
+    uint8_t i = watch.selected;
+    uint8_t bit = 1u << i;
+    uint16_t cfg;
+
+    if (p->stock_price != seen_stock || p->risk_free_rate != seen_rate
+            || p->dividend_yield != seen_yield) {
+        seen_stock = p->stock_price;
+        seen_rate  = p->risk_free_rate;
+        seen_yield = p->dividend_yield;
+        watch_dirty = WATCH_ALL;
+    }
+
+    if (p->market_price != watch_market(i)) {
+        live_market[i] = p->market_price;
+        live_mask |= bit;
+    }
+    if (p->strike_price != watch.strike_price[i] || p->time_to_exp != watch.time_to_exp[i]
+            || p->volatility != watch.volatility[i]) {
+        cfg = fram_unlock();
+        watch.strike_price[i] = p->strike_price;
+        watch.time_to_exp[i]  = p->time_to_exp;
+        watch.volatility[i]   = p->volatility;
+        flush_market(i);
+        fram_lock(cfg);
+        watch_dirty |= bit;
+    }
+
+    if (!(watch_dirty & bit)) {
+        watch_pct[i] = pct_diff(p->market_price, watch_call_price[i]);
+    }
+}
+
+static void sync(void) {
+    struct option_params p;
+    uint16_t version = params_version();
+
+    if (version != seen_version) {
+        params_snapshot(&p);
+        sync_selected(&p);
+        seen_version = version;
+    }
+    if (volsurf_version() != seen_surface) {
+        seen_surface = volsurf_version();
+        watch_dirty = WATCH_ALL;
+    }
+}
+
+/**
+ * Background work for one idle slot: pick up parameter edits, then
+ * reprice at most one dirty contract. Call from the main loop.
+ */
+void watch_idle(void) {
+    struct option_params p;
+    struct bs_result res;
+    uint8_t i;
+
+    sync();
+    if (!watch_dirty) return;
+
+    for (i = 0; !(watch_dirty & (1u << i)); i++) ;
+
+    p.stock_price    = seen_stock;
+    p.risk_free_rate = seen_rate;
+    p.dividend_yield = seen_yield;
+    p.strike_price   = watch.strike_price[i];
+    p.time_to_exp    = watch.time_to_exp[i];
+    p.volatility     = watch.volatility[i];
+    p.market_price   = watch_market(i);
+    volsurf_apply(&p);
+
+    TRACE(TRACE_EV_PRICE_START, 3);
+    bs_price(&p, &res);
+    TRACE(TRACE_EV_PRICE_END, 3);
+    watch_call_price[i] = res.call;
+    watch_pct[i] = res.pct_diff;
+    watch_dirty &= ~(1u << i);
+}
+
+/**
+ * Make the live parameters describe the selected contract.
+ */
+void watch_load_selected(void) {
+    uint8_t i = watch.selected;
+    params_set(PARAM_STRIKE_PRICE, watch.strike_price[i]);
+    params_set(PARAM_TIME_EXP,     watch.time_to_exp[i]);
+    params_set(PARAM_VOLATILITY,   watch.volatility[i]);
+    params_set(PARAM_MKT_PRICE,    watch_market(i));
+}
+
+/**
+ * Restore the live parameters on a warm start: the shared inputs from the
+ * persisted record, the contract from the selected slot. Selecting a
+ * contract and UART sets of K, T or V write the slot without saving the
+ * record, so the record's contract can be stale, and the next sync would
+ * copy it over the slot.
+ *
+ * @param: saved Parameters from persist_load().
+ *
+ * @return: 1 if the record's contract is the one loaded, so the result
+ *          saved with it still applies.
+ */
+uint8_t watch_restore(const struct option_params *saved) {
+    struct option_params p;
+
+    params_restore(saved);
+    watch_load_selected();
+    params_snapshot(&p);
+    return p.strike_price == saved->strike_price && p.time_to_exp == saved->time_to_exp
+        && p.volatility == saved->volatility && p.market_price == saved->market_price;
+}
+
+/**
+ * Select the next contract, wrapping, and load it into the live
+ * parameters. Pending edits to the current one are saved first.
+ *
+ * @return: Index of the newly selected contract.
+ */
+uint8_t watch_select_next(void) {
+    uint16_t cfg;
+
+    sync();
+    cfg = fram_unlock();
+    flush_market(watch.selected);
+    watch.selected = (watch.selected + 1 < watch.count) ? watch.selected + 1 : 0;
+    fram_lock(cfg);
+    watch_load_selected();
+    return watch.selected;
+}
+
+uint8_t watch_count(void) {
+    return watch.count;
+}
+
+uint8_t watch_selected(void) {
+    return watch.selected;
+}
+
+uint8_t watch_is_dirty(uint8_t i) {
+    return (watch_dirty >> i) & 1;
+}
+
+float watch_strike(uint8_t i) {
+    return watch.strike_price[i];
+}
+
+float watch_market(uint8_t i) {
+    return (live_mask & (1u << i)) ? live_market[i] : watch.market_price[i];
+}
+
+float watch_call(uint8_t i) {
+    return watch_call_price[i];
+}
+
+float watch_pct_diff(uint8_t i) {
+    return watch_pct[i];
+}
@@ -0,0 +1,34 @@
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include <stdint.h>
+#include "params.h"
+
+#define WATCH_MAX 4                         // At most 8: dirty bits are one byte
+
+/**
+ * Per-contract inputs, one array per field. The underlying, rate and
+ * dividend yield are shared and come from the live parameters.
+ */
+struct watch_contracts {
+    uint8_t count;
+    uint8_t selected;                       // Slot mirrored in the live parameters
+    float strike_price[WATCH_MAX];
+    float time_to_exp[WATCH_MAX];
+    float volatility[WATCH_MAX];
+    float market_price[WATCH_MAX];
+};
+
+void    watch_idle(void);
+void    watch_load_selected(void);
+uint8_t watch_restore(const struct option_params *saved);
+uint8_t watch_select_next(void);
+uint8_t watch_count(void);
+uint8_t watch_selected(void);
+uint8_t watch_is_dirty(uint8_t i);
+float   watch_strike(uint8_t i);
+float   watch_market(uint8_t i);
+float   watch_call(uint8_t i);
+float   watch_pct_diff(uint8_t i);
+
+#endif // WATCHLIST_H
@@ -67,6 +67,7 @@
 //******************************************************************************
 #include <msp430.h>
 #include "../src/ledbar.h"
+#include "../src/trace.h"
 
 
 
@@ -96,6 +97,7 @@ int main(void)
     setup_ledbar();
 
     setup_status_led();
+    setup_trace();
     ledbar_i2c_slave_setup();
                                             // to activate previously configured port settings
     //UCB0CTLW0 &= ~UCSWRST;
@@ -106,7 +108,9 @@ int main(void)
 
     while(1)
     {
-        
+        if (trace_dump_requested) {
+            trace_dump();
+        }
     }
 }
 
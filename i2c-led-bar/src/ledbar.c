@@ -1,5 +1,6 @@
 #include <msp430fr2311.h>
 #include <stdint.h>
+#include "trace.h"
 
 volatile uint8_t pattern = -1; // Current pattern
 volatile uint8_t step[4] = {0, 0, 0, 0}; // Current step in each pattern
@@ -19,6 +20,7 @@ void setup_ledbar() {
 
 void update_ledbar_pins(int pins) {
     int current_pins = pins;
+    TRACE(TRACE_EV_LED_UPDATE, pins);
 
     if ((current_pins & 0b00000001) == 1) {
         P1OUT |= BIT0;
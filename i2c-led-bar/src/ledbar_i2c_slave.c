@@ -1,5 +1,6 @@
 #include <msp430fr2311.h>
 #include "ledbar.h"
+#include "trace.h"
 #include <stdint.h>
 
 void ledbar_i2c_slave_setup() {
@@ -37,9 +38,11 @@ __interrupt void EUSCI_B0_ISR(void) {
     int current = UCB0IV;
     switch(current) {
         case 0x08:
+            TRACE(TRACE_EV_I2C_STOP, 0);
             break;
         case 0x16:
             led_data = UCB0RXBUF;
+            TRACE(TRACE_EV_I2C_RX, led_data);
             update_ledbar_pins(led_data);
             P2OUT |= BIT7;
             idle_count=0;
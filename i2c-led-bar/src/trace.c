@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief Binary event trace for the LED bar, same format as the controller's.
+ *
+ * See controller/src/trace.c for the record and WRAP scheme. Dumping needs
+ * the TRACE_UART build, since the only eUSCI_A pins are LED bar outputs.
+ */
+#include <msp430fr2311.h>
+#include "trace.h"
+
+#define SMCLK_HZ      1000000UL             // Default DCODIV
+#define TRACE_TICK_HZ (SMCLK_HZ / 8)
+#define UART_N        (SMCLK_HZ / TRACE_UART_BAUD)
+
+struct trace_rec trace_buf[TRACE_DEPTH];
+volatile uint8_t trace_head = 0;
+volatile uint8_t trace_on = 1;
+volatile uint8_t trace_dump_requested = 0;
+
+static uint8_t wrap_count = 0;
+static uint8_t head_at_wrap = 0;
+
+void setup_trace(void) {
+    TB1CTL = TBSSEL__SMCLK | MC__CONTINUOUS | ID__8 | TBCLR | TBIE;   // Overflow interrupt
+
+#ifdef TRACE_UART
+    UCA0CTLW0 |= UCSWRST;
+    UCA0CTLW0 |= UCSSEL__SMCLK;
+    UCA0BRW = UART_N / 16;
+    UCA0MCTLW = UCOS16 | ((UART_N % 16) << 4) | 0x2000;   // UCBRSx = 0x20 for 1 MHz / 9600
+    P1SEL1 &= ~(BIT6 | BIT7);
+    P1SEL0 |= (BIT6 | BIT7);
+    UCA0CTLW0 &= ~UCSWRST;
+    UCA0IE |= UCRXIE;
+#endif
+}
+
+#ifdef TRACE_UART
+static void uart_putc(uint8_t c) {
+    while (!(UCA0IFG & UCTXIFG));
+    UCA0TXBUF = c;
+}
+
+static void uart_put16(uint16_t v) {
+    uart_putc(v & 0xFF);
+    uart_putc(v >> 8);
+}
+#endif
+
+/**
+ * Send the whole buffer, oldest record first, in the controller's frame
+ * format. Does nothing unless built with TRACE_UART.
+ */
+void trace_dump(void) {
+#ifdef TRACE_UART
+    uint16_t i;
+    uint32_t hz = TRACE_TICK_HZ;
+
+    trace_on = 0;
+    uint8_t h = trace_head;
+
+    uart_putc('T');
+    uart_putc('R');
+    uart_putc('C');
+    uart_putc(TRACE_BOARD);
+    uart_put16(hz & 0xFFFF);
+    uart_put16(hz >> 16);
+    uart_put16(TRACE_DEPTH);
+    for (i = 0; i < TRACE_DEPTH; i++) {
+        const struct trace_rec *r = &trace_buf[(h + i) & (TRACE_DEPTH - 1)];
+        uart_put16(r->ts);
+        uart_putc(r->id);
+        uart_putc(r->arg);
+    }
+    trace_on = 1;
+#endif
+    trace_dump_requested = 0;
+}
+
+#pragma vector=TIMER1_B1_VECTOR
+__interrupt void Timer_B1_Overflow_ISR(void) {
+    switch (__even_in_range(TB1IV, TBIV__TBIFG)) {
+        case TBIV__TBIFG:
+            wrap_count++;
+            if (trace_head != head_at_wrap) {
+                TRACE(TRACE_EV_WRAP, wrap_count);
+                head_at_wrap = trace_head;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+#ifdef TRACE_UART
+#pragma vector=EUSCI_A0_VECTOR
+__interrupt void EUSCI_A0_ISR(void) {
+    switch (__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG)) {
+        case USCI_UART_UCRXIFG:
+            if (UCA0RXBUF == 'D') {
+                trace_dump_requested = 1;   // Dumped from the main loop
+            }
+            break;
+        default:
+            break;
+    }
+}
+#endif
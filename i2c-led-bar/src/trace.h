@@ -0,0 +1,70 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <msp430.h>
+#include <stdint.h>
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1                      // Set to 0 to compile all TRACE() calls out
+#endif
+
+#define TRACE_DEPTH   32                    // Records, power of 2 (1 KB of RAM on the FR2310)
+#define TRACE_BOARD   'L'                   // LED bar
+#define TRACE_TIMER   TB1R                  // Free-running SMCLK / 8
+
+// Event IDs, shared with controller/src/trace.h and tools/trace_decode.c
+#define TRACE_EV_NONE        0
+#define TRACE_EV_WRAP        1              // arg: timer wrap counter
+#define TRACE_EV_KEY         2              // arg: key character
+#define TRACE_EV_ENC         3              // arg: encoder delta (int8)
+#define TRACE_EV_PRICE_START 4
+#define TRACE_EV_PRICE_END   5
+#define TRACE_EV_I2C_START   6              // arg: data byte
+#define TRACE_EV_I2C_STOP    7
+#define TRACE_EV_I2C_NACK    8
+#define TRACE_EV_LCD_FLUSH   9              // arg: characters written
+#define TRACE_EV_I2C_RX      10             // arg: data byte
+#define TRACE_EV_LED_UPDATE  11             // arg: LED pattern
+#define TRACE_EV_I2C_ERR     12             // Controller only
+#define TRACE_EV_I2C_RECOVER 13             // Controller only
+#define TRACE_EV_SNAP_START  14             // Controller only
+#define TRACE_EV_SNAP_END    15             // Controller only
+
+struct trace_rec {
+    uint16_t ts;
+    uint8_t  id;
+    uint8_t  arg;
+};
+
+extern struct trace_rec trace_buf[TRACE_DEPTH];
+extern volatile uint8_t trace_head;
+extern volatile uint8_t trace_on;
+
+#if TRACE_ENABLE
+// Safe from ISRs and main; a handful of instructions per record.
+#define TRACE(ev, a) do {                                       \
+        unsigned short sr_ = __get_interrupt_state();           \
+        __disable_interrupt();                                  \
+        if (trace_on) {                                         \
+            uint8_t h_ = trace_head;                            \
+            trace_buf[h_].ts  = TRACE_TIMER;                    \
+            trace_buf[h_].id  = (ev);                           \
+            trace_buf[h_].arg = (uint8_t)(a);                   \
+            trace_head = (h_ + 1) & (TRACE_DEPTH - 1);          \
+        }                                                       \
+        __set_interrupt_state(sr_);                             \
+    } while (0)
+#else
+#define TRACE(ev, a) do { } while (0)
+#endif
+
+// Build with TRACE_UART defined to dump over eUSCI_A0 (P1.6 RXD, P1.7 TXD).
+// Those pins drive LED bar segments 4 and 5, which stay dark in that build.
+#define TRACE_UART_BAUD 9600UL
+
+extern volatile uint8_t trace_dump_requested;
+
+void setup_trace(void);
+void trace_dump(void);
+
+#endif // TRACE_H
@@ -0,0 +1,197 @@
+/**
+ * @file
+ * @brief Check the batch pricer against the firmware and time it.
+ *
+ * Generates random contracts, a sixteenth each with T = 0, sigma = 0,
+ * S = 0, K = 0 and a negative T so the fast paths are covered, and half
+ * with a dividend yield. The reference is the controller's
+ * black_scholes_call() for q = 0 and bs_prepare()/bs_pair_at() otherwise,
+ * one contract at a time. Every kernel is then compared with it:
+ * the firmware kernel must be bit-identical, the SIMD kernels within
+ * BENCH_TOL of the contract's notional S e^-qT + K e^-rT.
+ *
+ * Each kernel is then timed on one thread and on the pool, and reported
+ * as contracts per second, and per second per core the pool ran on.
+ *
+ * Usage: batch_bench [-n contracts] [-t threads] [-r repeats] [-s seed]
+ *   -t 0 (the default) uses one thread per online CPU.
+ *
+ * Exits 1 if a kernel fails the comparison.
+ */
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bs_batch.h"
+#include "black_scholes.h"
+
+#define BENCH_TOL 2e-6                      // Of notional
+
+struct contracts {
+    size_t n;
+    float *S, *K, *T, *r, *q, *sigma;
+};
+
+static uint64_t rng_state;
+
+static double uniform(void) {               // xorshift64, [0, 1)
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static float *alloc_floats(size_t n) {
+    float *p = aligned_alloc(64, (n * sizeof(float) + 63) & ~(size_t)63);
+    if (!p) {
+        perror("aligned_alloc");
+        exit(2);
+    }
+    return p;
+}
+
+static void generate(struct contracts *c) {
+    size_t i;
+    for (i = 0; i < c->n; i++) {
+        c->S[i]     = (float)(1.0 + uniform() * 199.0);
+        c->K[i]     = (float)(1.0 + uniform() * 199.0);
+        c->T[i]     = (float)(uniform() * 3.0);
+        c->r[i]     = (float)(uniform() * 0.1);
+        c->q[i]     = (i & 1) ? (float)(uniform() * 0.08) : 0.0f;
+        c->sigma[i] = (float)(0.01 + uniform() * 1.5);
+        switch (i % 16) {
+            case 2:  c->T[i] = 0.0f;       break;
+            case 4:  c->sigma[i] = 0.0f;   break;
+            case 6:  c->S[i] = 0.0f;       break;
+            case 8:  c->K[i] = 0.0f;       break;
+            case 10: c->T[i] = -c->T[i];   break;
+            default:                       break;
+        }
+    }
+}
+
+static void reference(const struct contracts *c, float *call, float *put) {
+    struct bs_shared sh;
+    struct bs_terms t;
+    size_t i;
+
+    for (i = 0; i < c->n; i++) {
+        bs_prepare(&sh, c->S[i], c->T[i], c->r[i], c->q[i], c->sigma[i]);
+        call[i] = bs_pair_at(&sh, c->K[i], &t, &put[i]);
+        if (c->q[i] == 0.0f) {
+            call[i] = black_scholes_call(c->S[i], c->K[i], c->T[i], c->r[i], c->sigma[i]);
+        }
+    }
+}
+
+// Report agreement with the reference; nonzero if the kernel fails it
+static int compare(const struct contracts *c, enum bs_kernel kernel,
+                   const float *ref_call, const float *ref_put,
+                   const float *call, const float *put) {
+    double worst = 0.0;
+    size_t i, same = 0, bad = 0;
+
+    for (i = 0; i < c->n; i++) {
+        double T = c->T[i] > 0.0f ? c->T[i] : 0.0;
+        double notional = c->S[i] * exp(-c->q[i] * T) + c->K[i] * exp(-c->r[i] * T);
+        double err = fmax(fabs((double)call[i] - ref_call[i]), fabs((double)put[i] - ref_put[i]));
+        if (!(notional > 0.0)) notional = 1.0;
+        if (call[i] == ref_call[i] && put[i] == ref_put[i]) same++;
+        if (!(err <= BENCH_TOL * notional)) bad++;  // Also catches NaN
+        if (err / notional > worst) worst = err / notional;
+    }
+    printf("  %-8s  %zu/%zu bit-identical, worst error %.2e of notional\n",
+           bs_kernel_name(kernel), same, c->n, worst);
+    return kernel == BS_KERNEL_FIRMWARE ? same != c->n : bad != 0;
+}
+
+static double best_time(struct bs_pool *pool, const struct bs_batch *b,
+                        enum bs_kernel kernel, unsigned repeats) {
+    double best = 1e30;
+    unsigned i;
+    for (i = 0; i < repeats; i++) {
+        double t0 = now_s();
+        bs_batch_price(pool, b, kernel);
+        double dt = now_s() - t0;
+        if (dt < best) best = dt;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    static const enum bs_kernel kernels[] = {
+        BS_KERNEL_FIRMWARE, BS_KERNEL_SCALAR, BS_KERNEL_SSE2, BS_KERNEL_AVX2,
+    };
+    struct contracts c = {1000000, 0, 0, 0, 0, 0, 0};
+    unsigned threads = 0, repeats = 5;
+    unsigned k;
+    int opt, failed = 0;
+
+    rng_state = 88172645463325252ULL;
+    while ((opt = getopt(argc, argv, "n:t:r:s:")) != -1) {
+        switch (opt) {
+            case 'n': c.n = strtoul(optarg, NULL, 10); break;
+            case 't': threads = (unsigned)strtoul(optarg, NULL, 10); break;
+            case 'r': repeats = (unsigned)strtoul(optarg, NULL, 10); break;
+            case 's': rng_state = strtoull(optarg, NULL, 10) | 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n contracts] [-t threads] [-r repeats] [-s seed]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (c.n == 0 || repeats == 0) return 2;
+
+    c.S = alloc_floats(c.n);
+    c.K = alloc_floats(c.n);
+    c.T = alloc_floats(c.n);
+    c.r = alloc_floats(c.n);
+    c.q = alloc_floats(c.n);
+    c.sigma = alloc_floats(c.n);
+    float *ref_call = alloc_floats(c.n), *ref_put = alloc_floats(c.n);
+    float *call = alloc_floats(c.n), *put = alloc_floats(c.n);
+    struct bs_batch b = {c.n, c.S, c.K, c.T, c.r, c.q, c.sigma, call, put};
+
+    generate(&c);
+    reference(&c, ref_call, ref_put);
+
+    struct bs_pool *pool = bs_pool_create(threads);
+    if (!pool) {
+        perror("bs_pool_create");
+        return 2;
+    }
+    unsigned nthreads = bs_pool_threads(pool);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned cores = (cpus > 0 && (unsigned long)cpus < nthreads) ? (unsigned)cpus : nthreads;
+
+    printf("%zu contracts against the firmware's black_scholes_call():\n", c.n);
+    for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!bs_kernel_supported(kernels[k])) continue;
+        bs_batch_price(pool, &b, kernels[k]);
+        failed |= compare(&c, kernels[k], ref_call, ref_put, call, put);
+    }
+
+    printf("\nthroughput, best of %u (%u thread%s in the pool):\n", repeats, nthreads,
+           nthreads == 1 ? "" : "s");
+    printf("  %-8s  %14s  %14s  %14s\n", "kernel", "1 thread /s", "pool /s", "per core /s");
+    for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!bs_kernel_supported(kernels[k])) continue;
+        double one = c.n / best_time(NULL, &b, kernels[k], repeats);
+        double all = c.n / best_time(pool, &b, kernels[k], repeats);
+        printf("  %-8s  %14.0f  %14.0f  %14.0f\n", bs_kernel_name(kernels[k]),
+               one, all, all / cores);
+    }
+
+    bs_pool_destroy(pool);
+    return failed;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file
+ * @brief Kernel dispatch and the thread pool for bs_batch_price().
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bs_batch.h"
+#include "bs_kernel.h"
+#include "black_scholes.h"
+
+#define BS_CHUNK 4096                       // Contracts per work item
+
+struct bs_pool {
+    unsigned threads;                       // Including the caller
+    pthread_t *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned generation;                    // Bumped per job
+    unsigned busy;                          // Workers still on the job
+    int quit;
+
+    const struct bs_batch *batch;
+    bs_kernel_fn fn;
+    atomic_size_t next;                     // First contract of the next chunk
+};
+
+// The controller's own code, one contract at a time
+static void firmware_kernel(const struct bs_batch *b, size_t lo, size_t hi) {
+    struct bs_shared sh;
+    struct bs_terms t;
+    float put;
+    size_t i;
+
+    for (i = lo; i < hi; i++) {
+        bs_prepare(&sh, b->S[i], b->T[i], b->r[i], b->q ? b->q[i] : 0.0f, b->sigma[i]);
+        b->call[i] = bs_pair_at(&sh, b->K[i], &t, &put);
+        if (b->put) b->put[i] = put;
+    }
+}
+
+int bs_kernel_supported(enum bs_kernel kernel) {
+    switch (kernel) {
+        case BS_KERNEL_FIRMWARE:
+        case BS_KERNEL_SCALAR:
+        case BS_KERNEL_BEST:
+            return 1;
+#ifdef BS_BATCH_X86
+        case BS_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case BS_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+        default:
+            return 0;
+    }
+}
+
+static enum bs_kernel resolve(enum bs_kernel kernel) {
+    if (kernel != BS_KERNEL_BEST) return kernel;
+    if (bs_kernel_supported(BS_KERNEL_AVX2)) return BS_KERNEL_AVX2;
+    if (bs_kernel_supported(BS_KERNEL_SSE2)) return BS_KERNEL_SSE2;
+    return BS_KERNEL_SCALAR;
+}
+
+const char *bs_kernel_name(enum bs_kernel kernel) {
+    switch (resolve(kernel)) {
+        case BS_KERNEL_FIRMWARE: return "firmware";
+        case BS_KERNEL_SCALAR:   return "scalar";
+        case BS_KERNEL_SSE2:     return "sse2";
+        case BS_KERNEL_AVX2:     return "avx2";
+        default:                 return "?";
+    }
+}
+
+static bs_kernel_fn kernel_fn(enum bs_kernel kernel) {
+    switch (resolve(kernel)) {
+#ifdef BS_BATCH_X86
+        case BS_KERNEL_SSE2:     return bs_kernel_sse2;
+        case BS_KERNEL_AVX2:     return bs_kernel_avx2;
+#endif
+        case BS_KERNEL_SCALAR:   return bs_kernel_scalar;
+        default:                 return firmware_kernel;
+    }
+}
+
+static void run_chunks(struct bs_pool *pool) {
+    size_t n = pool->batch->n;
+    for (;;) {
+        size_t lo = atomic_fetch_add(&pool->next, BS_CHUNK);
+        if (lo >= n) break;
+        pool->fn(pool->batch, lo, (n - lo < BS_CHUNK) ? n : lo + BS_CHUNK);
+    }
+}
+
+static void *worker(void *arg) {
+    struct bs_pool *pool = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->quit) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * Start a pool of threads - 1 workers; the caller of bs_batch_price() is
+ * the last thread.
+ *
+ * @param: threads Total threads, 0 for one per online CPU.
+ *
+ * @return: The pool, which may have fewer threads if some could not be
+ *          started, or NULL if out of memory.
+ */
+struct bs_pool *bs_pool_create(unsigned threads) {
+    struct bs_pool *pool = calloc(1, sizeof(*pool));
+    unsigned i;
+
+    if (!pool) return NULL;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (unsigned)cpus : 1;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->workers = calloc(threads, sizeof(pthread_t));
+    pool->threads = 1;
+    for (i = 1; pool->workers && i < threads; i++) {
+        if (pthread_create(&pool->workers[i - 1], NULL, worker, pool)) break;
+        pool->threads++;
+    }
+    if (!pool->workers) {
+        bs_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void bs_pool_destroy(struct bs_pool *pool) {
+    unsigned i;
+
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i + 1 < pool->threads; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+unsigned bs_pool_threads(const struct bs_pool *pool) {
+    return pool ? pool->threads : 1;
+}
+
+/**
+ * Price every contract of a batch.
+ *
+ * @param: pool   Thread pool, or NULL to run on the calling thread only.
+ * @param: b      Contracts and output arrays.
+ * @param: kernel Kernel; one this CPU lacks falls back to the firmware's.
+ */
+void bs_batch_price(struct bs_pool *pool, const struct bs_batch *b, enum bs_kernel kernel) {
+    bs_kernel_fn fn = bs_kernel_supported(kernel) ? kernel_fn(kernel) : firmware_kernel;
+
+    if (!pool || pool->threads == 1 || b->n <= BS_CHUNK) {
+        fn(b, 0, b->n);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->batch = b;
+    pool->fn = fn;
+    atomic_store(&pool->next, 0);
+    pool->busy = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
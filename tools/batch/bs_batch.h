@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Host batch pricer for whole chains, mirroring the controller's
+ * Black-Scholes kernel (controller/src/black_scholes.c).
+ *
+ * Contracts are passed in structure-of-arrays form so a SIMD kernel can
+ * load eight of each input with one instruction. Two families of kernel:
+ *
+ *   BS_KERNEL_FIRMWARE  the controller's own bs_prepare()/bs_pair_at(),
+ *                       linked from controller/src: bit-identical to
+ *                       black_scholes_call() built with the same libm.
+ *   BS_KERNEL_AVX2/SSE2/SCALAR
+ *                       the same formula, fast paths and saturation on
+ *                       8, 4 or 1 lanes, with polynomial log, exp and
+ *                       erfc in place of libm. Within a few float ulps of
+ *                       the firmware; batch_bench measures the gap.
+ *
+ * Work is split into fixed-size chunks pulled by a thread pool; the
+ * calling thread takes chunks too.
+ */
+#ifndef BS_BATCH_H
+#define BS_BATCH_H
+
+#include <stddef.h>
+
+enum bs_kernel {
+    BS_KERNEL_FIRMWARE,
+    BS_KERNEL_SCALAR,
+    BS_KERNEL_SSE2,
+    BS_KERNEL_AVX2,
+    BS_KERNEL_BEST,                         // Widest SIMD kernel this CPU runs
+};
+
+/**
+ * n contracts, one array per parameter. q may be NULL for no dividend;
+ * put may be NULL if only calls are wanted.
+ */
+struct bs_batch {
+    size_t n;
+    const float *S;
+    const float *K;
+    const float *T;
+    const float *r;
+    const float *q;
+    const float *sigma;
+    float *call;
+    float *put;
+};
+
+struct bs_pool;
+
+struct bs_pool *bs_pool_create(unsigned threads);
+void            bs_pool_destroy(struct bs_pool *pool);
+unsigned        bs_pool_threads(const struct bs_pool *pool);
+
+int             bs_kernel_supported(enum bs_kernel kernel);
+const char     *bs_kernel_name(enum bs_kernel kernel);
+void            bs_batch_price(struct bs_pool *pool, const struct bs_batch *b,
+                               enum bs_kernel kernel);
+
+#endif // BS_BATCH_H
@@ -0,0 +1,184 @@
+/**
+ * @file
+ * @brief SIMD Black-Scholes kernel, written once with GCC vector
+ * extensions and built per instruction set:
+ *
+ *   BSK_LANES=8 BSK_NAME=bs_kernel_avx2    with -mavx2 -mfma
+ *   BSK_LANES=4 BSK_NAME=bs_kernel_sse2    with -msse2
+ *   BSK_LANES=1 BSK_NAME=bs_kernel_scalar  anywhere
+ *
+ * It follows controller/src/black_scholes.c step for step: T clamped at
+ * 0, the discounted forward payoff when there is nothing to diffuse or S
+ * or K is not positive, N(d) saturated beyond 6 standard deviations, and
+ * the put from the same N(d1), N(d2). libm is replaced by branch-free
+ * polynomials (Cephes logf/expf, Numerical Recipes erfc), each within a
+ * couple of float ulps.
+ */
+#include <stdint.h>
+#include <string.h>
+#include "bs_kernel.h"
+
+#ifndef BSK_LANES
+#define BSK_LANES 1
+#endif
+#ifndef BSK_NAME
+#define BSK_NAME bs_kernel_scalar
+#endif
+
+#if BSK_LANES == 8
+#include <immintrin.h>
+#elif BSK_LANES == 4
+#include <emmintrin.h>
+#else
+#include <math.h>
+#endif
+
+typedef float   vf __attribute__((vector_size(BSK_LANES * sizeof(float))));
+typedef int32_t vi __attribute__((vector_size(BSK_LANES * sizeof(int32_t))));
+
+#define CDF_SATURATE 6.0f                   // As in black_scholes.c
+#define INV_SQRT2    0.70710678f
+
+static inline vf splat(float x) {
+    return (vf){0} + x;
+}
+
+// Lanes of a where m is set, of b elsewhere
+static inline vf sel(vi m, vf a, vf b) {
+    return (vf)(((vi)a & m) | ((vi)b & ~m));
+}
+
+static inline vf v_sqrt(vf x) {
+#if BSK_LANES == 8
+    return (vf)_mm256_sqrt_ps((__m256)x);
+#elif BSK_LANES == 4
+    return (vf)_mm_sqrt_ps((__m128)x);
+#else
+    return (vf){sqrtf(x[0])};
+#endif
+}
+
+// floor() as integers, for the exponent split in v_exp()
+static inline vi v_floor_i(vf x) {
+    vi i = __builtin_convertvector(x, vi);
+    return i + (vi)(__builtin_convertvector(i, vf) > x);    // -1 where truncation rounded up
+}
+
+// e^x; clamped to [-86, 88] so 2^n stays a normal float
+static inline vf v_exp(vf x) {
+    x = sel(x < -86.0f, splat(-86.0f), x);
+    x = sel(x > 88.0f, splat(88.0f), x);
+
+    vi n = v_floor_i(x * 1.44269504f + 0.5f);
+    vf fn = __builtin_convertvector(n, vf);
+    vf r = x - fn * 0.693359375f + fn * 2.12194440e-4f;
+
+    vf y = splat(1.9875691500e-4f);
+    y = y * r + 1.3981999507e-3f;
+    y = y * r + 8.3334519073e-3f;
+    y = y * r + 4.1665795894e-2f;
+    y = y * r + 1.6666665459e-1f;
+    y = y * r + 5.0000001201e-1f;
+    y = y * r * r + r + 1.0f;
+    return (vf)((vi)y + (n << 23));
+}
+
+// ln(x) for positive, normal x
+static inline vf v_log(vf x) {
+    vi e = ((vi)x >> 23) - 126;
+    vf m = (vf)(((vi)x & 0x007fffff) | 0x3f000000);        // [0.5, 1)
+    vi small = m < 0.70710678f;
+    e += small;                                             // -1 where m is doubled
+    m = m - 1.0f + (vf)((vi)m & small);
+
+    vf z = m * m;
+    vf y = splat(7.0376836292e-2f);
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y = y * m * z;
+
+    vf fe = __builtin_convertvector(e, vf);
+    y = y - fe * 2.12194440e-4f - 0.5f * z;
+    return m + y + fe * 0.693359375f;
+}
+
+/**
+ * N(x) from erfc (fractional error < 1.2e-7), so both tails keep their
+ * relative precision; 1 or 0 beyond CDF_SATURATE, like norm_cdf().
+ */
+static inline vf v_norm_cdf(vf x) {
+    vi neg = x < 0.0f;
+    vf z = sel(neg, -x, x) * INV_SQRT2;
+    vf t = 1.0f / (1.0f + 0.5f * z);
+
+    vf p = splat(0.17087277f);
+    p = p * t - 0.82215223f;
+    p = p * t + 1.48851587f;
+    p = p * t - 1.13520398f;
+    p = p * t + 0.27886807f;
+    p = p * t - 0.18628806f;
+    p = p * t + 0.09678418f;
+    p = p * t + 0.37409196f;
+    p = p * t + 1.00002368f;
+    p = p * t - 1.26551223f;
+    vf tail = 0.5f * t * v_exp(p - z * z);                  // N(-|x|)
+
+    vf n = sel(neg, tail, 1.0f - tail);
+    n = sel(x > CDF_SATURATE, splat(1.0f), n);
+    return sel(x < -CDF_SATURATE, splat(0.0f), n);
+}
+
+// Up to BSK_LANES floats; missing lanes get fill
+static inline vf load(const float *p, size_t count, float fill) {
+    vf v = splat(fill);
+    if (p) memcpy(&v, p, count * sizeof(float));
+    return v;
+}
+
+void BSK_NAME(const struct bs_batch *b, size_t lo, size_t hi) {
+    const vf one = splat(1.0f);
+    size_t i;
+
+    for (i = lo; i < hi; i += BSK_LANES) {
+        size_t count = (hi - i < BSK_LANES) ? hi - i : BSK_LANES;
+        vf S     = load(b->S + i, count, 1.0f);
+        vf K     = load(b->K + i, count, 1.0f);
+        vf T     = load(b->T + i, count, 0.0f);
+        vf r     = load(b->r + i, count, 0.0f);
+        vf q     = load(b->q ? b->q + i : NULL, count, 0.0f);
+        vf sigma = load(b->sigma + i, count, 0.0f);
+
+        // bs_prepare()
+        T = sel(T < 0.0f, splat(0.0f), T);
+        vf sst   = sigma * v_sqrt(T);
+        vf drift = (r - q + 0.5f * sigma * sigma) * T;
+        vf disc  = v_exp(-r * T);
+        vf fwd   = S * v_exp(-q * T);            // e^0 is exactly 1, as the firmware's q == 0 case
+        vf kd    = K * disc;
+
+        // Degenerate lanes take the forward payoff; give them safe operands
+        vi deg = (sst <= 0.0f) | (S <= 0.0f) | (K <= 0.0f);
+        vf ln_sk = v_log(sel(deg, one, S)) - v_log(sel(deg, one, K));
+        vf inv_sst = one / sel(deg, one, sst);
+
+        // bs_call_at() / bs_pair_at()
+        vf d1 = (ln_sk + drift) * inv_sst;
+        vf d2 = d1 - sst;
+        vf step = (vf)((vi)one & (fwd - kd > 0.0f));
+        vf nd1 = sel(deg, step, v_norm_cdf(d1));
+        vf nd2 = sel(deg, step, v_norm_cdf(d2));
+
+        vf call = fwd * nd1 - kd * nd2;
+        memcpy(b->call + i, &call, count * sizeof(float));
+        if (b->put) {
+            vf put = kd * (one - nd2) - fwd * (one - nd1);
+            memcpy(b->put + i, &put, count * sizeof(float));
+        }
+    }
+}
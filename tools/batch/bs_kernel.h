@@ -0,0 +1,18 @@
+/**
+ * @file
+ * @brief Kernels behind bs_batch_price(). Each prices contracts [lo, hi)
+ * of a batch; bs_kernel.c is built once per instruction set.
+ */
+#ifndef BS_KERNEL_H
+#define BS_KERNEL_H
+
+#include <stddef.h>
+#include "bs_batch.h"
+
+typedef void (*bs_kernel_fn)(const struct bs_batch *b, size_t lo, size_t hi);
+
+void bs_kernel_scalar(const struct bs_batch *b, size_t lo, size_t hi);
+void bs_kernel_sse2(const struct bs_batch *b, size_t lo, size_t hi);
+void bs_kernel_avx2(const struct bs_batch *b, size_t lo, size_t hi);
+
+#endif // BS_KERNEL_H
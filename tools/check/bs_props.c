@@ -0,0 +1,203 @@
+/**
+ * @file
+ * @brief Property test for the controller's Black-Scholes kernel.
+ *
+ * Prices random contracts through bs_prepare()/bs_pair_at(), built from
+ * controller/src/black_scholes.c, and checks what must hold whatever the
+ * inputs:
+ *
+ *   finite     call and put are finite numbers
+ *   bounds     max(F - D, 0) <= C <= F and max(D - F, 0) <= P <= D,
+ *              with F = S e^-qT and D = K e^-rT
+ *   parity     C - P = F - D
+ *   spot       C does not fall and P does not rise as S rises
+ *   vol        neither falls as sigma rises
+ *   time       C does not fall as T rises, when q = 0
+ *   reference  within BS_REF_TOL of a double-precision evaluation
+ *
+ * Spot and strike are log-uniform over 0.01..1000 so deep in- and
+ * out-of-the-money contracts are common, T runs to 3 years and sigma to
+ * 1.5. A sixteenth each have T = 0, sigma = 0, S = 0, K = 0 or a
+ * negative T, to cover the fast paths. Tolerances are relative to the
+ * notional F + D.
+ *
+ * Usage: bs_props [-n contracts] [-s seed]
+ *
+ * Exits 1 if any property fails, printing the first failing contract.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "black_scholes.h"
+
+#define BS_TOL     1e-6                     // Of notional, for bounds, parity and monotonicity
+#define BS_REF_TOL 1e-6                     // Of notional, against the double reference
+#define BS_BUMP    1e-3f                    // Relative bump for the monotonicity checks
+
+enum prop {
+    PROP_FINITE,
+    PROP_BOUNDS,
+    PROP_PARITY,
+    PROP_SPOT,
+    PROP_VOL,
+    PROP_TIME,
+    PROP_REFERENCE,
+    PROP_COUNT,
+};
+
+static const char *const prop_names[PROP_COUNT] = {
+    "finite", "bounds", "parity", "spot", "vol", "time", "reference",
+};
+
+struct contract {
+    float S, K, T, r, q, sigma;
+};
+
+static uint64_t rng_state;
+static unsigned long failures[PROP_COUNT];
+static double worst[PROP_COUNT];           // Largest error seen, of notional
+
+static double uniform(void) {               // xorshift64, [0, 1)
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void generate(struct contract *c, unsigned long i) {
+    c->S     = (float)(0.01 * pow(1e5, uniform()));
+    c->K     = (float)(0.01 * pow(1e5, uniform()));
+    c->T     = (float)(uniform() * 3.0);
+    c->r     = (float)(uniform() * 0.1);
+    c->q     = (i & 1) ? (float)(uniform() * 0.1) : 0.0f;
+    c->sigma = (float)(0.01 + uniform() * 1.49);
+    switch (i % 16) {
+        case 2:  c->T = 0.0f;       break;
+        case 4:  c->sigma = 0.0f;   break;
+        case 6:  c->S = 0.0f;       break;
+        case 8:  c->K = 0.0f;       break;
+        case 10: c->T = -c->T;      break;
+        default:                    break;
+    }
+}
+
+static float price(const struct contract *c, float *put) {
+    struct bs_shared sh;
+    struct bs_terms t;
+    bs_prepare(&sh, c->S, c->T, c->r, c->q, c->sigma);
+    return bs_pair_at(&sh, c->K, &t, put);
+}
+
+static double norm_cdf_d(double x) {
+    return 0.5 * erfc(-x / sqrt(2.0));
+}
+
+static void reference(const struct contract *c, double *call, double *put) {
+    double T = (c->T > 0.0f) ? c->T : 0.0;
+    double fwd = c->S * exp(-c->q * T);
+    double kd = c->K * exp(-c->r * T);
+    double sst = c->sigma * sqrt(T);
+
+    if (sst <= 0.0 || c->S <= 0.0f || c->K <= 0.0f) {
+        *call = fmax(fwd - kd, 0.0);
+        *put = fmax(kd - fwd, 0.0);
+        return;
+    }
+    double d1 = (log((double)c->S / c->K) + (c->r - c->q + 0.5 * c->sigma * c->sigma) * T) / sst;
+    double d2 = d1 - sst;
+    *call = fwd * norm_cdf_d(d1) - kd * norm_cdf_d(d2);
+    *put = kd * norm_cdf_d(-d2) - fwd * norm_cdf_d(-d1);
+}
+
+static void fail(enum prop prop, const struct contract *c, double err) {
+    if (err > worst[prop] || isnan(err)) worst[prop] = err;
+    if (failures[prop]++ == 0) {
+        printf("  %s fails first at S=%.9g K=%.9g T=%.9g r=%.9g q=%.9g sigma=%.9g\n",
+               prop_names[prop], c->S, c->K, c->T, c->r, c->q, c->sigma);
+    }
+}
+
+// Record err against tol; NaN counts as a failure
+static void check(enum prop prop, const struct contract *c, double err, double tol) {
+    if (!(err <= tol)) {
+        fail(prop, c, err);
+    } else if (err > worst[prop]) {
+        worst[prop] = err;
+    }
+}
+
+static void test_one(const struct contract *c) {
+    double T = (c->T > 0.0f) ? c->T : 0.0;
+    double fwd = c->S * exp(-c->q * T);
+    double kd = c->K * exp(-c->r * T);
+    double notional = (fwd + kd > 0.0) ? fwd + kd : 1.0;
+    double ref_call, ref_put;
+    struct contract b;
+    float put, put_b;
+    float call = price(c, &put);
+
+    if (!isfinite(call) || !isfinite(put)) {
+        fail(PROP_FINITE, c, NAN);
+        return;
+    }
+
+    double over = fmax(fmax(call - fwd, put - kd), 0.0);
+    double under = fmax(fmax(fwd - kd - call, kd - fwd - put), fmax(-call, -put));
+    check(PROP_BOUNDS, c, fmax(over, under) / notional, BS_TOL);
+    check(PROP_PARITY, c, fabs((call - put) - (fwd - kd)) / notional, BS_TOL);
+
+    b = *c;
+    b.S = c->S * (1.0f + BS_BUMP);
+    float call_b = price(&b, &put_b);
+    check(PROP_SPOT, c, fmax(call - call_b, put_b - put) / notional, BS_TOL);
+
+    b = *c;
+    b.sigma = c->sigma * (1.0f + BS_BUMP) + BS_BUMP;
+    call_b = price(&b, &put_b);
+    check(PROP_VOL, c, fmax(call - call_b, put - put_b) / notional, BS_TOL);
+
+    // With a dividend an early expiry can be worth more; without one it cannot
+    if (c->q == 0.0f) {
+        b = *c;
+        b.T = c->T * (1.0f + BS_BUMP) + BS_BUMP;
+        call_b = price(&b, &put_b);
+        check(PROP_TIME, c, (call - call_b) / notional, BS_TOL);
+    }
+
+    reference(c, &ref_call, &ref_put);
+    check(PROP_REFERENCE, c, fmax(fabs(call - ref_call), fabs(put - ref_put)) / notional,
+          BS_REF_TOL);
+}
+
+int main(int argc, char **argv) {
+    unsigned long n = 2000000, i;
+    struct contract c;
+    int opt, failed = 0;
+    unsigned k;
+
+    rng_state = 88172645463325252ULL;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': n = strtoul(optarg, NULL, 10); break;
+            case 's': rng_state = strtoull(optarg, NULL, 10) | 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n contracts] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    printf("%lu contracts through bs_prepare()/bs_pair_at():\n", n);
+    for (i = 0; i < n; i++) {
+        generate(&c, i);
+        test_one(&c);
+    }
+    for (k = 0; k < PROP_COUNT; k++) {
+        printf("  %-10s  %8lu failures, worst %.2e of notional\n",
+               prop_names[k], failures[k], worst[k]);
+        failed |= failures[k] != 0;
+    }
+    return failed;
+}
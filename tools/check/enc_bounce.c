@@ -0,0 +1,202 @@
+/**
+ * @file
+ * @brief Drive controller/src/rotary.c's ISRs with a bouncing encoder.
+ *
+ * Built twice, as enc_bounce_edge (ENCODER_SAMPLED=0) and
+ * enc_bounce_sampled (ENCODER_SAMPLED=1), against the register stand-ins
+ * in check/include. A model knob steps through the quadrature states at a
+ * given rate, each step jittered by +-30%. After every step the line that
+ * changed bounces for up to a given time, in pulses under BOUNCE_PULSE_US.
+ * The pins are resolved to 1 us:
+ *
+ *   edge       P3IFG is set on each edge P3IES selects; PORT3_ISR() runs
+ *              1 us later, unless the previous call is still running
+ *   sampled    Timer_B2_ISR() runs every TB2CCR0 + 1 ACLK periods
+ *
+ * encoder_get_delta() is read every 20 ms, as the main loop does, and the
+ * sum is compared with the steps the knob really made. Each case prints
+ * the ISR rate, its CPU load at an estimated cost per call, and the count
+ * error. Cases marked exact must have no error. The rest show where the
+ * decoder runs out and are printed only.
+ *
+ * Usage: enc_bounce_edge, enc_bounce_sampled
+ *
+ * Exits 1 if an exact case is off.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "clock.h"
+#include "rotary.h"
+
+#define STATES          4000                // Quadrature steps per case
+#define BOUNCE_PULSE_US 40                  // Longest single bounce pulse
+#define READ_US         20000               // encoder_get_delta() period
+#define EDGE_CYCLES     60                  // PORT3_ISR() entry, body and RETI, estimated
+#define SAMPLE_CYCLES   40                  // Timer_B2_ISR(), estimated
+
+volatile uint16_t P3SEL0, P3SEL1, P3DIR, P3REN, P3OUT, P3IN, P3IES, P3IE, P3IFG;
+volatile uint16_t TB2CTL, TB2CCTL0, TB2CCR0;
+
+void PORT3_ISR(void);
+void Timer_B2_ISR(void);
+
+struct enc_case {
+    float rate;                             // Steps per second
+    float bounce_us;                        // Longest bounce after a step
+    uint8_t reverse;                        // Turn back after half the steps
+    uint8_t exact_edge;                     // Must count exactly, per decoder
+    uint8_t exact_sampled;
+};
+
+static const struct enc_case cases[] = {
+    { 400,    0, 0, 1, 1},
+    { 400,  300, 0, 0, 1},
+    { 400, 1000, 0, 0, 1},
+    { 800,  300, 0, 0, 1},
+    { 800, 1000, 0, 0, 0},
+    {1200, 1000, 0, 0, 0},
+    { 100,  300, 1, 0, 1},
+    { 400,    0, 1, 1, 1},
+    { 400, 1000, 1, 0, 1},
+};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static const uint8_t gray[4] = {0, 1, 3, 2}; // B:A, the order that counts up
+
+static uint64_t rng_state;
+
+static double uniform(void) {               // xorshift64, [0, 1)
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// The model knob, advanced 1 us at a time
+struct knob {
+    const struct enc_case *c;
+    long steps;                             // Steps made so far
+    long truth;                             // Their signed sum
+    int dir;
+    uint8_t pos;                            // Index into gray[]
+    long next_step;                         // Time of the next step
+    uint8_t bounce_bit;                     // Line bouncing, as a B:A mask
+    long bounce_end;
+    long pulse_end;                         // End of the current bounce pulse
+    uint8_t pulse_flipped;
+};
+
+static void knob_init(struct knob *k, const struct enc_case *c) {
+    k->c = c;
+    k->steps = 0;
+    k->truth = 0;
+    k->dir = +1;
+    k->pos = 2;                             // Both high, as the pull-ups leave it
+    k->next_step = 10000;
+    k->bounce_end = 0;
+    k->pulse_end = 0;
+    k->pulse_flipped = 0;
+}
+
+// Pin state, B:A, at time t
+static uint8_t knob_at(struct knob *k, long t) {
+    if (t == k->next_step && k->steps < STATES) {
+        if (k->c->reverse && k->steps == STATES / 2) k->dir = -k->dir;
+        uint8_t was = gray[k->pos];
+        k->pos = (uint8_t)((k->pos + k->dir) & 3);
+        k->truth += k->dir;
+        k->steps++;
+        k->bounce_bit = was ^ gray[k->pos];
+        k->bounce_end = t + (long)(uniform() * k->c->bounce_us);
+        k->pulse_end = t;
+        k->next_step = t + 1 + (long)(1e6 / k->c->rate * (0.7 + 0.6 * uniform()));
+    }
+    uint8_t s = gray[k->pos];
+    if (t < k->bounce_end) {
+        if (t >= k->pulse_end) {
+            k->pulse_end = t + 1 + (long)(uniform() * BOUNCE_PULSE_US);
+            k->pulse_flipped = uniform() < 0.5;
+        }
+        if (k->pulse_flipped) s ^= k->bounce_bit;
+    }
+    return s;
+}
+
+/**
+ * Run one case through the decoder this build has.
+ *
+ * @param: c    The case.
+ * @param: isrs ISR calls made.
+ * @param: us   Length of the run.
+ * @return: Counts decoded minus steps made.
+ */
+static long run(const struct enc_case *c, long *isrs, long *us) {
+    struct knob k;
+    long t, end = 0, decoded = 0;
+
+    knob_init(&k, c);
+    *isrs = 0;
+    P3IN = (uint16_t)(knob_at(&k, 0) << 4);
+    setup_encoder();
+    encoder_get_delta();
+
+#if ENCODER_SAMPLED
+    double period = 1e6 * (TB2CCR0 + 1) / ACLK_HZ, next_sample = period;
+#else
+    long busy_until = 0, pending = -1;
+    uint16_t prev = P3IN;
+#endif
+    for (t = 1; end == 0 || t < end; t++) {
+        uint16_t now = (uint16_t)(knob_at(&k, t) << 4);
+        P3IN = now;
+#if ENCODER_SAMPLED
+        if (t >= next_sample) {
+            next_sample += period;
+            Timer_B2_ISR();
+            (*isrs)++;
+        }
+#else
+        P3IFG |= ((~prev & now & ~P3IES) | (prev & ~now & P3IES)) & (BIT4 | BIT5);
+        prev = now;
+        if (pending < 0 && t >= busy_until && (P3IFG & P3IE)) pending = t + 1;
+        if (pending >= 0 && t >= pending) {
+            PORT3_ISR();
+            (*isrs)++;
+            pending = -1;
+            busy_until = t + (long)ceil(EDGE_CYCLES / (MCLK_HZ / 1e6));
+        }
+#endif
+        if (t % READ_US == 0) decoded += encoder_get_delta();
+        if (end == 0 && k.steps == STATES) end = k.next_step + 20000;
+    }
+    decoded += encoder_get_delta();
+    *us = t;
+    return decoded - k.truth;
+}
+
+int main(void) {
+    const char *name = ENCODER_SAMPLED ? "sampled" : "edge";
+    double cycles = ENCODER_SAMPLED ? SAMPLE_CYCLES : EDGE_CYCLES;
+    unsigned i;
+    int failed = 0;
+
+    printf("  %s decoder, %d steps a case:\n", name, STATES);
+    for (i = 0; i < COUNT(cases); i++) {
+        const struct enc_case *c = &cases[i];
+        uint8_t exact = ENCODER_SAMPLED ? c->exact_sampled : c->exact_edge;
+        long isrs, us;
+
+        rng_state = 88172645463325252ULL + i;
+        long err = run(c, &isrs, &us);
+        double per_s = isrs / (us / 1e6);
+        printf("  %5.0f/s  bounce %4.0f us  %-8s  %6.0f ISR/s  load %5.2f%%  error %+5ld%s\n",
+               c->rate, c->bounce_us, c->reverse ? "reversed" : "forward", per_s,
+               per_s * cycles / MCLK_HZ * 100.0, err,
+               !exact ? "" : err == 0 ? "  exact" : "  FAIL");
+        if (exact && err != 0) failed = 1;
+    }
+    return failed;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file
+ * @brief Exhaustive check of controller/src/fmt.c against snprintf().
+ *
+ * Three sweeps, each compared character for character with the C
+ * library's "%*.*f" of the same value:
+ *
+ *   encoder    every value the parameter editor can reach: each
+ *              parameter's 0..range_for() walked up and back down at
+ *              each step size, accumulating in float with the editor's
+ *              clamp, shown as the LCD does, fmt_float(v, 2, 5, FMT_ZERO)
+ *   uart       every value a UART set can give in range, scaled / 10^4,
+ *              at the 2 and 4 decimals the LCD and P/G replies use
+ *   fixed      fmt_fixed() at every precision, width 0..12 and flag
+ *              combination, for all scaled values in +/-FIXED_SPAN and
+ *              near the int32 limits
+ *
+ * fmt_float() scales and rounds in float, half away from zero, while
+ * snprintf() rounds the exact binary value half to even. Those can only
+ * differ when v * 10^prec is within a float ulp of a .5 tie; such values
+ * are counted as ties, and any other difference is a failure.
+ *
+ * The parameter ranges and step sizes are the editor's own, range_for()
+ * and step_values from controller/src/param_edit.c.
+ *
+ * Usage: fmt_check
+ *
+ * Exits 1 on any failure, printing the first few.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "param_edit.h"
+#include "params.h"
+
+#define FIXED_SPAN  300000L                 // fmt_fixed() sweep, each side of 0
+#define SHOW_FAILS  5                       // Failures printed per sweep
+
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+struct sweep {
+    const char *name;
+    unsigned long checked;
+    unsigned long ties;
+    unsigned long failures;
+};
+
+static void mismatch(struct sweep *sw, const char *what, const char *got, const char *want) {
+    if (sw->failures++ < SHOW_FAILS) {
+        printf("  %s: %s gives \"%s\", snprintf \"%s\"\n", sw->name, what, got, want);
+    }
+}
+
+// The printf conversion matching fmt.c's flags
+static const char *ref_format(uint8_t flags) {
+    switch (flags & (FMT_PLUS | FMT_ZERO)) {
+        case FMT_PLUS:            return "%+*.*f";
+        case FMT_ZERO:            return "%0*.*f";
+        case FMT_PLUS | FMT_ZERO: return "%+0*.*f";
+        default:                  return "%*.*f";
+    }
+}
+
+/**
+ * Whether v * 10^prec is close enough to a .5 tie for float rounding to
+ * matter: within one float ulp of it, or on it exactly once the float
+ * product is whole and so already correctly rounded.
+ */
+static int near_tie(float v, uint8_t prec) {
+    double s = fabs((double)v * pow(10.0, prec));
+    double frac = s - floor(s);
+    double ulp = nextafterf((float)s, INFINITY) - (float)s;
+    return (ulp < 1.0) ? fabs(frac - 0.5) <= ulp : frac == 0.5;
+}
+
+static void check_float(struct sweep *sw, float v, uint8_t prec, uint8_t width, uint8_t flags) {
+    char got[32], want[32], what[64];
+
+    fmt_float(got, v, prec, width, flags);
+    snprintf(want, sizeof(want), ref_format(flags), width, prec, (double)v);
+    sw->checked++;
+    if (strcmp(got, want) == 0) return;
+    if (near_tie(v, prec)) {
+        sw->ties++;
+        return;
+    }
+    snprintf(what, sizeof(what), "fmt_float(%.9g, %u, %u, %u)", v, prec, width, flags);
+    mismatch(sw, what, got, want);
+}
+
+static void sweep_encoder(struct sweep *sw) {
+    unsigned s;
+    int p;
+
+    for (p = 1; p <= PARAM_COUNT; p++) {
+        float range = range_for(p);
+        for (s = 0; s < NUM_STEPS; s++) {
+            float step = step_values[s];
+            float v = 0.0f;
+            // Up from 0 to the clamp, then back down: float accumulation
+            // drifts differently each way
+            for (;;) {
+                check_float(sw, v, 2, 5, FMT_ZERO);
+                if (v >= range) break;
+                v += step;
+                if (v > range) v = range;
+            }
+            for (;;) {
+                v -= step;
+                if (v < 0.0f) v = 0.0f;
+                check_float(sw, v, 2, 5, FMT_ZERO);
+                if (v <= 0.0f) break;
+            }
+        }
+    }
+}
+
+static void sweep_uart(struct sweep *sw) {
+    int p;
+    int32_t scaled;
+
+    for (p = 1; p <= PARAM_COUNT; p++) {
+        int32_t top = (int32_t)lroundf(range_for(p) * 10000.0f);
+        for (scaled = 0; scaled <= top; scaled++) {
+            float v = (float)scaled * 0.0001f;  // As cmd.c sets it
+            check_float(sw, v, 2, 5, FMT_ZERO);
+            check_float(sw, v, 4, 0, 0);
+        }
+    }
+}
+
+static void check_fixed(struct sweep *sw, int32_t scaled, uint8_t prec, uint8_t width,
+                        uint8_t flags) {
+    static const double pow10[] = {1.0, 10.0, 100.0, 1000.0, 10000.0};
+    char got[32], want[32], what[64];
+
+    fmt_fixed(got, scaled, prec, width, flags);
+    snprintf(want, sizeof(want), ref_format(flags), width, prec, scaled / pow10[prec]);
+    sw->checked++;
+    if (strcmp(got, want) != 0) {
+        snprintf(what, sizeof(what), "fmt_fixed(%ld, %u, %u, %u)", (long)scaled, prec, width, flags);
+        mismatch(sw, what, got, want);
+    }
+}
+
+static void sweep_fixed(struct sweep *sw) {
+    static const int32_t edges[] = {INT32_MIN, INT32_MIN + 1, -INT32_MAX + 1, INT32_MAX - 1,
+                                    INT32_MAX};
+    int32_t scaled;
+    uint8_t prec, width, flags;
+    unsigned e;
+
+    for (prec = 0; prec <= 4; prec++) {
+        for (flags = 0; flags <= (FMT_PLUS | FMT_ZERO); flags++) {
+            for (scaled = -FIXED_SPAN; scaled <= FIXED_SPAN; scaled++) {
+                check_fixed(sw, scaled, prec, (uint8_t)(scaled & 7) + 2, flags);
+            }
+            for (width = 0; width <= 12; width++) {
+                for (e = 0; e < COUNT(edges); e++) check_fixed(sw, edges[e], prec, width, flags);
+                for (scaled = -1000; scaled <= 1000; scaled++) {
+                    check_fixed(sw, scaled, prec, width, flags);
+                }
+            }
+        }
+    }
+}
+
+int main(void) {
+    struct sweep sweeps[] = {{"encoder", 0, 0, 0}, {"uart", 0, 0, 0}, {"fixed", 0, 0, 0}};
+    int failed = 0;
+    unsigned i;
+
+    sweep_encoder(&sweeps[0]);
+    sweep_uart(&sweeps[1]);
+    sweep_fixed(&sweeps[2]);
+
+    for (i = 0; i < COUNT(sweeps); i++) {
+        printf("  %-8s  %10lu checked, %6lu within a float ulp of a tie, %lu failures\n",
+               sweeps[i].name, sweeps[i].checked, sweeps[i].ties, sweeps[i].failures);
+        failed |= sweeps[i].failures != 0;
+    }
+    return failed;
+}
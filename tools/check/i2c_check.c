@@ -0,0 +1,274 @@
+/**
+ * @file
+ * @brief Check the I2C retry and recovery policy in controller/src/i2c_bus.c.
+ *
+ * Links i2c_bus.c against a scripted fake of the three transfer-level
+ * calls in i2c_master.h. Each transfer is charged I2C_TIMEOUT_US, the most
+ * the master can spend on one, and each recovery RECOVER_US, 9 SCL pulses
+ * and a STOP. Once a transfer leaves SDA stuck, every transfer times out
+ * until a recovery frees it.
+ *
+ *   scripts    every sequence of I2C_RETRIES + 1 outcomes (ok, NACK, lost
+ *              arbitration, timeout, timeout with SDA stuck), with bus
+ *              recovery working and failing: the attempts made, the
+ *              return value, each i2c_errors counter, the recoveries, and
+ *              that SDA is never left stuck when recovery works
+ *   bound      no write takes longer than (I2C_RETRIES + 1) deadlines plus
+ *              one recovery per attempt, and a write that gets stuck every
+ *              time takes exactly that
+ *   random     n writes with random faults: i2c_errors matches the fake's
+ *              own tally of every outcome
+ *
+ * Usage: i2c_check [-n writes] [-s seed]
+ *
+ * Exits 1 on any failure, printing the first.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "i2c_bus.h"
+#include "i2c_master.h"
+
+#define ATTEMPTS   (I2C_RETRIES + 1)
+#define RECOVER_US (10UL * 1000000UL / I2C_BUS_HZ)
+#define WRITE_MAX  (ATTEMPTS * (I2C_TIMEOUT_US + RECOVER_US))
+
+// Scripted outcome of one transfer
+enum step { STEP_OK, STEP_NACK, STEP_AL, STEP_TIMEOUT, STEP_STUCK, STEP_COUNT };
+
+static const char step_chars[STEP_COUNT] = {'o', 'n', 'a', 't', 's'};
+
+// The fake bus
+static uint8_t script[ATTEMPTS];
+static uint8_t script_len, script_pos;
+static uint8_t sda_stuck, recover_works;
+static unsigned long elapsed_us, recover_calls;
+static unsigned long failures;
+
+// Random mode, and the fake's own tally of the outcomes it gave
+static int random_mode;
+static uint64_t rng_state;
+static struct i2c_errors tally;
+
+static double uniform(void) {               // xorshift64, [0, 1)
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void fail(const char *what, const char *detail) {
+    if (failures++ == 0) printf("  FAIL: %s: %s\n", what, detail);
+}
+
+static uint8_t random_step(void) {
+    double u = uniform();
+    if (u < 0.70) return STEP_OK;
+    if (u < 0.80) return STEP_NACK;
+    if (u < 0.87) return STEP_AL;
+    if (u < 0.95) return STEP_TIMEOUT;
+    return STEP_STUCK;
+}
+
+uint8_t i2c_xfer_write(uint8_t addr, uint8_t byte) {
+    uint8_t step;
+
+    (void)byte;
+    if (addr != I2C_LEDBAR_ADDR) fail("address", "write not to I2C_LEDBAR_ADDR");
+    if (random_mode) {
+        step = random_step();
+    } else if (script_pos >= script_len) {
+        fail("attempts", "more than I2C_RETRIES + 1 transfers in one write");
+        step = STEP_OK;
+    } else {
+        step = script[script_pos];
+    }
+    script_pos++;
+    elapsed_us += I2C_TIMEOUT_US;
+
+    if (sda_stuck || step == STEP_STUCK) {
+        sda_stuck = 1;
+        tally.timeout++;
+        return I2C_TIMEOUT;
+    }
+    switch (step) {
+        case STEP_NACK:    tally.nack++;     return I2C_NACK;
+        case STEP_AL:      tally.arb_lost++; return I2C_ARB_LOST;
+        case STEP_TIMEOUT: tally.timeout++;  return I2C_TIMEOUT;
+        default:           return I2C_OK;
+    }
+}
+
+uint8_t i2c_sda_low(void) {
+    return sda_stuck;
+}
+
+uint8_t i2c_bus_recover(void) {
+    if (!sda_stuck) fail("recover", "bus recovery with SDA released");
+    recover_calls++;
+    elapsed_us += RECOVER_US;
+    if (recover_works) {
+        sda_stuck = 0;
+        tally.recovered++;
+    }
+    return recover_works;
+}
+
+struct expect {
+    uint8_t attempts;
+    uint8_t status;
+    struct i2c_errors errors;
+    uint8_t recoveries;
+};
+
+// What the policy promises for a script: up to ATTEMPTS transfers, each
+// failure counted by cause, and SDA recovered after any failure leaving it low
+static void model(const uint8_t *s, uint8_t works, struct expect *e) {
+    uint8_t a, stuck = 0;
+
+    memset(e, 0, sizeof(*e));
+    for (a = 0; a < ATTEMPTS; a++) {
+        e->attempts++;
+        if (!stuck && s[a] == STEP_OK) {
+            e->status = I2C_OK;
+            return;
+        }
+        if (stuck || s[a] == STEP_STUCK || s[a] == STEP_TIMEOUT) {
+            e->status = I2C_TIMEOUT;
+            e->errors.timeout++;
+        } else if (s[a] == STEP_NACK) {
+            e->status = I2C_NACK;
+            e->errors.nack++;
+        } else {
+            e->status = I2C_ARB_LOST;
+            e->errors.arb_lost++;
+        }
+        if (s[a] == STEP_STUCK) stuck = 1;
+        if (stuck) {
+            e->recoveries++;
+            if (works) {
+                stuck = 0;
+                e->errors.recovered++;
+            }
+        }
+    }
+    e->errors.failed = 1;
+}
+
+static void check_script(const uint8_t *s, uint8_t works, unsigned long *worst_us) {
+    char name[64], detail[128];
+    struct expect e;
+    uint8_t a;
+
+    for (a = 0; a < ATTEMPTS; a++) name[a] = step_chars[s[a]];
+    snprintf(name + ATTEMPTS, sizeof(name) - ATTEMPTS, ", recovery %s",
+             works ? "works" : "fails");
+
+    memcpy(script, s, ATTEMPTS);
+    script_len = ATTEMPTS;
+    script_pos = 0;
+    sda_stuck = 0;
+    recover_works = works;
+    recover_calls = 0;
+    elapsed_us = 0;
+    memset(&i2c_errors, 0, sizeof(i2c_errors));
+
+    uint8_t status = i2c_write_led(0x5A);
+    model(s, works, &e);
+
+    if (script_pos != e.attempts || status != e.status || recover_calls != e.recoveries ||
+        memcmp(&i2c_errors, &e.errors, sizeof(e.errors)) != 0) {
+        snprintf(detail, sizeof(detail),
+                 "%u attempts, status %u, %lu recoveries, errors %u %u %u %u %u; "
+                 "expected %u, %u, %u, %u %u %u %u %u",
+                 script_pos, status, recover_calls, i2c_errors.nack, i2c_errors.arb_lost,
+                 i2c_errors.timeout, i2c_errors.recovered, i2c_errors.failed, e.attempts,
+                 e.status, e.recoveries, e.errors.nack, e.errors.arb_lost, e.errors.timeout,
+                 e.errors.recovered, e.errors.failed);
+        fail(name, detail);
+    }
+    if (works && sda_stuck) fail(name, "SDA left stuck");
+    if (elapsed_us > WRITE_MAX) {
+        snprintf(detail, sizeof(detail), "took %lu us, bound %lu us", elapsed_us, WRITE_MAX);
+        fail(name, detail);
+    }
+    if (elapsed_us > *worst_us) *worst_us = elapsed_us;
+}
+
+static void run_scripts(void) {
+    uint8_t s[ATTEMPTS];
+    unsigned long worst_us = 0, scripts = 0;
+    unsigned n, total = 1, a, works;
+
+    for (a = 0; a < ATTEMPTS; a++) total *= STEP_COUNT;
+    for (works = 0; works <= 1; works++) {
+        for (n = 0; n < total; n++) {
+            unsigned v = n;
+            for (a = 0; a < ATTEMPTS; a++) {
+                s[a] = (uint8_t)(v % STEP_COUNT);
+                v /= STEP_COUNT;
+            }
+            check_script(s, (uint8_t)works, &worst_us);
+            scripts++;
+        }
+    }
+    if (worst_us != WRITE_MAX) fail("bound", "no script reached the worst case");
+    printf("  %lu scripts of %u attempts: worst write %lu us, bound %lu us\n", scripts,
+           ATTEMPTS, worst_us, WRITE_MAX);
+}
+
+static void run_random(unsigned long n) {
+    unsigned long i, failed = 0, worst_us = 0;
+
+    random_mode = 1;
+    recover_works = 1;
+    sda_stuck = 0;
+    memset(&i2c_errors, 0, sizeof(i2c_errors));
+    memset(&tally, 0, sizeof(tally));
+
+    for (i = 0; i < n; i++) {
+        script_pos = 0;
+        elapsed_us = 0;
+        if (i2c_write_led((uint8_t)i) != I2C_OK) failed++;
+        if (script_pos > ATTEMPTS) fail("random", "more than I2C_RETRIES + 1 transfers");
+        if (sda_stuck) fail("random", "SDA left stuck");
+        if (elapsed_us > worst_us) worst_us = elapsed_us;
+    }
+    tally.failed = (uint16_t)failed;
+    if (memcmp(&i2c_errors, &tally, sizeof(tally)) != 0) {
+        char detail[128];
+        snprintf(detail, sizeof(detail), "errors %u %u %u %u %u, fake saw %u %u %u %u %u",
+                 i2c_errors.nack, i2c_errors.arb_lost, i2c_errors.timeout, i2c_errors.recovered,
+                 i2c_errors.failed, tally.nack, tally.arb_lost, tally.timeout, tally.recovered,
+                 tally.failed);
+        fail("random", detail);
+    }
+    if (worst_us > WRITE_MAX) fail("random", "a write overran the bound");
+    printf("  %lu random writes: nack %u, arb %u, timeout %u, recovered %u, failed %u"
+           " (counters mod 65536)\n", n, i2c_errors.nack, i2c_errors.arb_lost,
+           i2c_errors.timeout, i2c_errors.recovered, i2c_errors.failed);
+}
+
+int main(int argc, char **argv) {
+    unsigned long n = 100000;
+    int opt;
+
+    rng_state = 88172645463325252ULL;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': n = strtoul(optarg, NULL, 10); break;
+            case 's': rng_state = strtoull(optarg, NULL, 10) | 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n writes] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    run_scripts();
+    run_random(n);
+    printf("  %lu failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file
+ * @brief Register stand-ins for host checks that link a driver.
+ *
+ * Declares only what the linked drivers touch; the check defines the
+ * registers and drives them. The simulator's own <msp430.h> is in
+ * tools/sim/include and has no peripherals.
+ */
+#ifndef CHECK_MSP430_H
+#define CHECK_MSP430_H
+
+#include <stdint.h>
+
+#define __interrupt
+#define __delay_cycles(x)         ((void)0)
+#define __disable_interrupt()     ((void)0)
+#define __enable_interrupt()      ((void)0)
+#define __get_interrupt_state()   ((unsigned short)0)
+#define __set_interrupt_state(x)  ((void)(x))
+
+#define BIT4         0x0010
+#define BIT5         0x0020
+#define CCIE         0x0010
+#define TBSSEL__ACLK 0x0100
+#define MC__UP       0x0010
+#define TBCLR        0x0004
+
+extern volatile uint16_t P3SEL0, P3SEL1, P3DIR, P3REN, P3OUT, P3IN, P3IES, P3IE, P3IFG;
+extern volatile uint16_t TB2CTL, TB2CCTL0, TB2CCR0;
+
+#endif // CHECK_MSP430_H
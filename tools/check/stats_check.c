@@ -0,0 +1,193 @@
+/**
+ * @file
+ * @brief Check controller/src/stats.c against a brute-force recompute.
+ *
+ * Feeds random-walk deviations through stats_add(), one per simulated
+ * second, with a step of STEP_SIZE percentage points halfway through and
+ * an outlier beyond stats.c's clamp every OUTLIER_EVERY samples. After
+ * every sample the summary is compared with the window and the history
+ * recomputed from scratch in double:
+ *
+ *   window     count, and mean and sample standard deviation of the last
+ *              STATS_DEPTH deviations quantized as stats.c does, within
+ *              EXACT_TOL of their own size: the running sums never drift
+ *   quantum    the same against the unquantized, clamped deviations,
+ *              within half a quantum (times sqrt(n / (n - 1)) for the
+ *              standard deviation)
+ *   history    EWMA, min and max since the reset
+ *   newest     z-score, span in seconds, stats_sample() order, and
+ *              stats_signal() against the z thresholds
+ *
+ * stats_reset() must then zero the summary, and the run is repeated to
+ * check everything restarts.
+ *
+ * Usage: stats_check [-n samples] [-s seed]
+ *
+ * Exits 1 on any failure, printing the first.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+#define STEP_SIZE     40.0                  // Percentage points
+#define OUTLIER_EVERY 500
+#define DEV_SCALE     1000                  // From stats.c: thousandths of a percent
+#define DEV_LIMIT     50000.0f              // From stats.c: clamp before quantizing
+#define EXACT_TOL     1e-6                  // Relative, against the quantized recompute
+#define HISTORY_TOL   1e-5                  // Of the history's scale
+
+volatile uint16_t uptime_s;
+
+static uint64_t rng_state;
+static unsigned long failures;
+static double worst_mean, worst_sd;         // Relative, against the quantized recompute
+
+// stats.c's quantize(), as a count of 1/DEV_SCALE percent
+static int32_t quantize(float dev) {
+    if (dev > DEV_LIMIT) dev = DEV_LIMIT;
+    if (dev < -DEV_LIMIT) dev = -DEV_LIMIT;
+    float s = dev * DEV_SCALE;
+    return (int32_t)(s < 0.0f ? s - 0.5f : s + 0.5f);
+}
+
+static double clamp(double dev) {
+    return (dev > DEV_LIMIT) ? DEV_LIMIT : (dev < -DEV_LIMIT) ? -DEV_LIMIT : dev;
+}
+
+// Mean and sample standard deviation of n values
+static void mean_sd(const double *v, unsigned long n, double *mean, double *sd) {
+    double m = 0.0, ss = 0.0;
+    unsigned long j;
+
+    for (j = 0; j < n; j++) m += v[j];
+    m /= n;
+    for (j = 0; j < n; j++) ss += (v[j] - m) * (v[j] - m);
+    *mean = m;
+    *sd = (n > 1) ? sqrt(ss / (n - 1)) : 0.0;
+}
+
+static double uniform(void) {               // xorshift64, [0, 1)
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void fail(unsigned long i, const char *what, double got, double want) {
+    if (failures++ == 0) {
+        printf("  sample %lu: %s is %.9g, expected %.9g\n", i, what, got, want);
+    }
+}
+
+static void close_to(unsigned long i, const char *what, double got, double want, double tol) {
+    if (!(fabs(got - want) <= tol)) fail(i, what, got, want);
+}
+
+/**
+ * Add n samples and check the summary after each.
+ *
+ * @param: n    Samples.
+ * @param: hist Deviations recorded so far since the reset; grows by n.
+ */
+static void run(unsigned long n, float *hist) {
+    struct stats_summary s;
+    double level = 0.0, ewma = 0.0, lo = 0.0, hi = 0.0, scale_h = 0.0;
+    unsigned long i, j;
+
+    for (i = 0; i < n; i++) {
+        level += (uniform() - 0.5) * 2.0;
+        float dev = (float)(level + ((i >= n / 2) ? STEP_SIZE : 0.0) + (uniform() - 0.5) * 4.0);
+        if (i % OUTLIER_EVERY == OUTLIER_EVERY - 1) dev = (uniform() < 0.5) ? -1e5f : 1e5f;
+        uptime_s += 1 + (uint16_t)(uniform() * 3.0);
+        stats_add(100.0f, 100.0f + dev, dev);
+        hist[i] = dev;
+
+        ewma = (i == 0) ? dev : ewma + STATS_EWMA_ALPHA * (dev - ewma);
+        lo = (i == 0 || dev < lo) ? dev : lo;
+        hi = (i == 0 || dev > hi) ? dev : hi;
+        if (fabs(dev) > scale_h) scale_h = fabs(dev);
+
+        unsigned long w = (i + 1 < STATS_DEPTH) ? i + 1 : STATS_DEPTH;
+        double quant[STATS_DEPTH], raw[STATS_DEPTH], mean, sd, raw_mean, raw_sd;
+        for (j = 0; j < w; j++) {
+            quant[j] = (double)quantize(hist[i + 1 - w + j]) / DEV_SCALE;
+            raw[j] = clamp(hist[i + 1 - w + j]);
+        }
+        mean_sd(quant, w, &mean, &sd);
+        mean_sd(raw, w, &raw_mean, &raw_sd);
+
+        stats_summary(&s);
+        if (s.count != w) fail(i, "count", s.count, w);
+        close_to(i, "mean", s.mean, mean, EXACT_TOL * fabs(mean) + 1e-12);
+        close_to(i, "stddev", s.stddev, sd, EXACT_TOL * sd + 1e-12);
+        if (fabs(s.mean - mean) / (fabs(mean) + 1e-12) > worst_mean) {
+            worst_mean = fabs(s.mean - mean) / (fabs(mean) + 1e-12);
+        }
+        if (fabs(s.stddev - sd) / (sd + 1e-12) > worst_sd) worst_sd = fabs(s.stddev - sd) / (sd + 1e-12);
+
+        double half_q = 0.5 / DEV_SCALE;
+        close_to(i, "mean against the raw window", s.mean, raw_mean,
+                 half_q + EXACT_TOL * fabs(raw_mean));
+        if (w > 1) {
+            close_to(i, "stddev against the raw window", s.stddev, raw_sd,
+                     half_q * sqrt((double)w / (w - 1)) + EXACT_TOL * raw_sd);
+        }
+
+        close_to(i, "ewma", s.ewma, ewma, HISTORY_TOL * (1.0 + scale_h));
+        if (s.min != (float)lo) fail(i, "min", s.min, lo);
+        if (s.max != (float)hi) fail(i, "max", s.max, hi);
+        if (stats_sample(0)->dev != dev) fail(i, "newest sample", stats_sample(0)->dev, dev);
+        if (stats_sample(w - 1)->dev != hist[i + 1 - w]) {
+            fail(i, "oldest sample", stats_sample(w - 1)->dev, hist[i + 1 - w]);
+        }
+        if (stats_sample(w) != 0) fail(i, "sample past the window", 1, 0);
+        uint16_t span = stats_sample(0)->time - stats_sample(w - 1)->time;
+        if (s.span != span) fail(i, "span", s.span, span);
+
+        double z = (s.stddev > 0.0f) ? (dev - s.mean) / s.stddev : 0.0;
+        close_to(i, "z", s.z, z, 1e-5 * (1.0 + fabs(z)));
+        int8_t want = (s.count < 2) ? STATS_HOLD : (s.z >= STATS_Z_ENTRY) ? STATS_SELL
+                    : (s.z <= -STATS_Z_ENTRY) ? STATS_BUY : STATS_HOLD;
+        if (stats_signal(&s) != want) fail(i, "signal", stats_signal(&s), want);
+    }
+}
+
+int main(int argc, char **argv) {
+    struct stats_summary s;
+    unsigned long n = 100000;
+    int opt;
+
+    rng_state = 88172645463325252ULL;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': n = strtoul(optarg, NULL, 10); break;
+            case 's': rng_state = strtoull(optarg, NULL, 10) | 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n < 2) return 2;
+
+    float *hist = malloc(n * sizeof(float));
+    if (!hist) return 2;
+
+    run(n, hist);
+    stats_reset();
+    stats_summary(&s);
+    if (s.count || s.mean != 0.0f || s.stddev != 0.0f || s.ewma != 0.0f || s.min != 0.0f
+            || s.max != 0.0f || s.z != 0.0f || s.span || s.added || stats_sample(0)) {
+        fail(n, "summary after stats_reset()", s.ewma, 0.0);
+    }
+    run(n, hist);
+    free(hist);
+
+    printf("  %lu samples twice, a %.0f point step and outliers in each: %lu failures\n", n,
+           STEP_SIZE, failures);
+    printf("  worst relative window error: mean %.2e, stddev %.2e\n", worst_mean, worst_sd);
+    return failures != 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file
+ * @brief Check the watchlist's repricing and FRAM write rate.
+ *
+ * Links controller/src/watchlist.c with params.c, black_scholes.c and
+ * volsurf.c, and counts fram_unlock() calls in place of the FRAM write
+ * protection. Drives the live parameters the way the UI and the UART do
+ * and checks, after each step has been given enough watch_idle() calls:
+ *
+ *   quotes     a stream of market price changes writes no FRAM, the
+ *              selected slot shows the last quote, and nothing reprices
+ *   shared     an underlying, rate or yield change writes no FRAM and
+ *              reprices every contract
+ *   contract   a strike, expiry or vol change writes FRAM once and
+ *              reprices only the selected contract
+ *   select     moving the selection writes FRAM once, and the quote the
+ *              slot had in RAM is what it reloads with
+ *   restore    a warm start from a record saved before the selection
+ *              moved, or before a UART strike set, loads the selected
+ *              slot, leaves every slot as it was and refuses the saved
+ *              result; from a current record it writes nothing and keeps it
+ *   prices     every contract's call and deviation match bs_price() of
+ *              its own inputs
+ *
+ * Usage: watch_check [-n quotes]
+ *
+ * Exits 1 on any failure.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "watchlist.h"
+#include "black_scholes.h"
+#include "persist.h"
+#include "volsurf.h"
+
+volatile uint16_t TB3R;
+
+static unsigned long unlocks;
+static int locked = 1;
+static int failed;
+
+uint16_t fram_unlock(void) {
+    if (!locked) {
+        printf("  FAIL: fram_unlock() while already unlocked\n");
+        failed = 1;
+    }
+    locked = 0;
+    unlocks++;
+    return 0;
+}
+
+void fram_lock(uint16_t cfg) {
+    (void)cfg;
+    locked = 1;
+}
+
+static void expect(int ok, const char *what) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failed = 1;
+}
+
+// Enough idle slots to reprice everything dirty
+static void settle(void) {
+    uint8_t i;
+    for (i = 0; i <= WATCH_MAX; i++) watch_idle();
+}
+
+// Contracts still dirty after one idle slot, which reprices the lowest
+static uint8_t dirty_mask(void) {
+    uint8_t i, mask = 0;
+    watch_idle();
+    for (i = 0; i < watch_count(); i++) mask |= watch_is_dirty(i) << i;
+    return mask;
+}
+
+// Slot inputs in FRAM, to compare across a warm start
+struct slots {
+    float strike[WATCH_MAX];
+    float market[WATCH_MAX];
+};
+
+static void save_slots(struct slots *s) {
+    uint8_t i;
+    for (i = 0; i < watch_count(); i++) {
+        s->strike[i] = watch_strike(i);
+        s->market[i] = watch_market(i);
+    }
+}
+
+static int slots_equal(const struct slots *a, const struct slots *b) {
+    uint8_t i;
+    for (i = 0; i < watch_count(); i++) {
+        if (a->strike[i] != b->strike[i] || a->market[i] != b->market[i]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Warm-start from saved as main() does, then run the idle loop, which is
+ * where a stale contract would be copied over the selected slot.
+ *
+ * @return: watch_restore()'s verdict on the saved result.
+ */
+static uint8_t warm_start(const struct option_params *saved) {
+    uint8_t same = watch_restore(saved);
+    settle();
+    return same;
+}
+
+static void check_restore(void) {
+    struct option_params saved, live;
+    struct slots before, after;
+    unsigned long writes;
+    uint8_t same;
+
+    settle();
+    params_snapshot(&saved);                // Confirmed on this slot
+    watch_select_next();                    // 'D': the record is not saved
+    settle();
+    save_slots(&before);
+    writes = unlocks;
+    same = warm_start(&saved);
+    save_slots(&after);
+    params_snapshot(&live);
+    printf("  warm start after the selection moved:\n");
+    expect(slots_equal(&before, &after) && unlocks == writes, "  every slot unchanged, no FRAM write");
+    expect(live.strike_price == watch_strike(watch_selected()), "  live strike is the selected slot's");
+    expect(!same, "  saved result refused");
+
+    params_snapshot(&saved);
+    params_set(PARAM_STRIKE_PRICE, params_get(PARAM_STRIKE_PRICE) + 5.0f);  // UART K
+    settle();
+    save_slots(&before);
+    writes = unlocks;
+    same = warm_start(&saved);
+    save_slots(&after);
+    printf("  warm start after a UART strike set:\n");
+    expect(slots_equal(&before, &after) && unlocks == writes, "  the new strike kept, no FRAM write");
+    expect(!same, "  saved result refused");
+
+    params_snapshot(&saved);
+    writes = unlocks;
+    same = warm_start(&saved);
+    printf("  warm start from a current record:\n");
+    expect(same && unlocks == writes, "  saved result kept, no FRAM write");
+}
+
+static int prices_match(void) {
+    struct option_params p;
+    struct bs_result res;
+    uint8_t i, sel = watch_selected();
+    int ok = 1;
+
+    for (i = 0; i < watch_count(); i++) {
+        while (watch_selected() != i) watch_select_next();
+        params_snapshot(&p);
+        volsurf_apply(&p);
+        bs_price(&p, &res);
+        settle();
+        if (watch_call(i) != res.call || watch_pct_diff(i) != res.pct_diff) {
+            printf("  slot %u: call %.6f pct %.6f, bs_price() %.6f %.6f\n", i,
+                   watch_call(i), watch_pct_diff(i), res.call, res.pct_diff);
+            ok = 0;
+        }
+    }
+    while (watch_selected() != sel) watch_select_next();
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    unsigned long quotes = 100000, q, before;
+    uint8_t sel;
+    float last = 0.0f;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': quotes = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-n quotes]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    watch_load_selected();
+    settle();
+    expect(dirty_mask() == 0, "initial pricing leaves nothing dirty");
+
+    before = unlocks;
+    for (q = 0; q < quotes; q++) {
+        last = 0.5f + (float)(q % 1000) * 0.001f;
+        params_set(PARAM_MKT_PRICE, last);
+        if (dirty_mask() != 0) break;
+    }
+    printf("  %lu market quotes:\n", quotes);
+    expect(unlocks == before, "  no FRAM writes");
+    expect(q == quotes, "  nothing repriced");
+    expect(watch_market(watch_selected()) == last, "  selected slot shows the last quote");
+
+    before = unlocks;
+    params_set(PARAM_STOCK_PRICE, params_get(PARAM_STOCK_PRICE) + 1.0f);
+    expect(dirty_mask() == (uint8_t)(((1u << watch_count()) - 1) & ~1u),
+           "underlying change reprices every contract");
+    expect(unlocks == before, "underlying change: no FRAM write");
+    params_set(PARAM_RISK_FREE, params_get(PARAM_RISK_FREE) + 0.01f);
+    params_set(PARAM_DIV_YIELD, params_get(PARAM_DIV_YIELD) + 0.01f);
+    expect(unlocks == before, "rate and yield changes: no FRAM write");
+    settle();
+
+    watch_select_next();                    // Not slot 0, which an idle slot reprices first
+    settle();
+    before = unlocks;
+    sel = watch_selected();
+    float call = watch_call(sel);
+    params_set(PARAM_STRIKE_PRICE, params_get(PARAM_STRIKE_PRICE) + 2.5f);
+    expect(dirty_mask() == 0 && watch_call(sel) != call,
+           "strike change reprices only the selected contract");
+    expect(unlocks == before + 1, "strike change: one FRAM write");
+
+    before = unlocks;
+    params_set(PARAM_MKT_PRICE, 1.25f);
+    watch_idle();
+    watch_select_next();
+    expect(unlocks == before + 1, "select next: one FRAM write");
+    while (watch_selected() != sel) watch_select_next();
+    expect(params_get(PARAM_MKT_PRICE) == 1.25f, "reselected slot reloads its last quote");
+
+    check_restore();
+    expect(prices_match(), "every slot's call and deviation match bs_price()");
+    expect(locked, "FRAM left locked");
+    return failed;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file
+ * @brief Replay a CSV of quote ticks into the controller and measure latency.
+ *
+ * Each CSV row becomes one protocol line ("S85.43 M0.69 P") sent over the
+ * serial port or the simulator's pty. The "P" reply closes the tick's
+ * quote-to-result latency; an "L <mask>" line from the simulated LED bar
+ * closes its quote-to-LED latency.
+ *
+ * The CSV header names the columns with the protocol letters S, K, T, V,
+ * R, M, Q; other columns are ignored and an empty cell leaves the parameter
+ * unchanged.
+ *
+ * Usage: quote_feeder -d device [-b baud] [-w window] [-n repeat] quotes.csv
+ *   -w keeps up to window ticks in flight (default 1: strict request/reply).
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_COLS      16
+#define LINE_MAX_LEN  48                    // Matches CMD_LINE_MAX on the controller
+#define REPLY_TIMEOUT_MS 2000
+
+struct tick {
+    char line[LINE_MAX_LEN];
+    double sent;
+    double result;          // 0 until the P/E reply arrives
+    double led;             // 0 until an L line is attributed
+};
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static speed_t baud_const(unsigned long baud) {
+    switch (baud) {
+        case 9600:   return B9600;
+        case 19200:  return B19200;
+        case 38400:  return B38400;
+        case 57600:  return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        default:     return B115200;
+    }
+}
+
+static int open_serial(const char *dev, unsigned long baud) {
+    int fd = open(dev, O_RDWR | O_NOCTTY);
+    if (fd < 0) return -1;
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, baud_const(baud));
+        cfsetospeed(&tio, baud_const(baud));
+        tio.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+static void write_all(int fd, const char *buf, size_t len) {
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            exit(1);
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+/**
+ * Turn the CSV into protocol lines.
+ *
+ * @return: Number of ticks; *out is malloc'd.
+ */
+static size_t load_csv(const char *path, struct tick **out) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    char buf[512];
+    char letters[MAX_COLS];
+    int ncols = 0;
+    size_t n = 0, cap = 256;
+    struct tick *t = calloc(cap, sizeof(*t));
+
+    if (!fgets(buf, sizeof(buf), f)) {
+        fprintf(stderr, "%s: empty file\n", path);
+        exit(1);
+    }
+    for (char *tok = strtok(buf, ",\r\n"); tok && ncols < MAX_COLS; tok = strtok(NULL, ",\r\n")) {
+        while (*tok == ' ') tok++;
+        char c = (char)(*tok & ~0x20);
+        letters[ncols++] = (strlen(tok) == 1 && strchr("SKTVRMQ", c)) ? c : 0;
+    }
+
+    while (fgets(buf, sizeof(buf), f)) {
+        char *p = buf;
+        int col = 0;
+        size_t len = 0;
+        while (*p && *p != '\n' && *p != '\r' && col < ncols) {
+            char *end = p + strcspn(p, ",\r\n");
+            if (letters[col] && end > p && len + (size_t)(end - p) + 3 < LINE_MAX_LEN - 3) {
+                t[n].line[len++] = letters[col];
+                memcpy(&t[n].line[len], p, (size_t)(end - p));
+                len += (size_t)(end - p);
+                t[n].line[len++] = ' ';
+            }
+            p = (*end == ',') ? end + 1 : end;
+            col++;
+        }
+        if (len == 0) continue;
+        memcpy(&t[n].line[len], "P\n", 3);
+        if (++n == cap) {
+            cap *= 2;
+            t = realloc(t, cap * sizeof(*t));
+        }
+    }
+    fclose(f);
+    *out = t;
+    return n;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *v, size_t n) {
+    if (n == 0) {
+        printf("%-16s no samples\n", name);
+        return;
+    }
+    qsort(v, n, sizeof(*v), cmp_double);
+    printf("%-16s n=%zu p50=%.1f us p99=%.1f us max=%.1f us\n",
+           name, n, v[n / 2], v[(size_t)((n - 1) * 0.99)], v[n - 1]);
+}
+
+int main(int argc, char **argv) {
+    const char *dev = NULL;
+    unsigned long baud = 115200;
+    size_t window = 1;
+    int repeat = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:b:w:n:")) != -1) {
+        switch (opt) {
+            case 'd': dev = optarg; break;
+            case 'b': baud = strtoul(optarg, NULL, 10); break;
+            case 'w': window = strtoul(optarg, NULL, 10); break;
+            case 'n': repeat = atoi(optarg); break;
+            default: goto usage;
+        }
+    }
+    if (!dev || optind >= argc || window == 0 || repeat < 1) {
+usage:
+        fprintf(stderr, "usage: %s -d device [-b baud] [-w window] [-n repeat] quotes.csv\n", argv[0]);
+        return 2;
+    }
+
+    struct tick *rows;
+    size_t nrows = load_csv(argv[optind], &rows);
+    if (nrows == 0) {
+        fprintf(stderr, "no ticks in %s\n", argv[optind]);
+        return 1;
+    }
+    size_t total = nrows * (size_t)repeat;
+    struct tick *ticks = calloc(total, sizeof(*ticks));
+    for (size_t i = 0; i < total; i++) {
+        memcpy(ticks[i].line, rows[i % nrows].line, LINE_MAX_LEN);
+    }
+    free(rows);
+
+    int fd = open_serial(dev, baud);
+    if (fd < 0) {
+        perror(dev);
+        return 1;
+    }
+    write_all(fd, "W0\n", 3);               // Replies only for our explicit P
+    usleep(50000);
+    tcflush(fd, TCIFLUSH);
+
+    size_t next_send = 0, next_reply = 0, errors = 0;
+    size_t last_answered = (size_t)-1;
+    char rbuf[128];
+    size_t rlen = 0;
+    double start = now_us();
+    double last_activity = start;
+
+    while (next_reply < total) {
+        while (next_send < total && next_send - next_reply < window) {
+            ticks[next_send].sent = now_us();
+            write_all(fd, ticks[next_send].line, strlen(ticks[next_send].line));
+            next_send++;
+        }
+
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int r = poll(&pfd, 1, 100);
+        if (r <= 0) {
+            if (now_us() - last_activity > REPLY_TIMEOUT_MS * 1000.0) {
+                fprintf(stderr, "timeout waiting for tick %zu\n", next_reply);
+                break;
+            }
+            continue;
+        }
+        ssize_t n = read(fd, rbuf + rlen, sizeof(rbuf) - 1 - rlen);
+        if (n <= 0) continue;
+        double t = now_us();
+        last_activity = t;
+        rlen += (size_t)n;
+
+        char *nl;
+        while ((nl = memchr(rbuf, '\n', rlen)) != NULL) {
+            *nl = '\0';
+            if (rbuf[0] == 'P' || rbuf[0] == 'E') {
+                if (rbuf[0] == 'E') errors++;
+                if (next_reply < next_send) {
+                    ticks[next_reply].result = t;
+                    last_answered = next_reply++;
+                }
+            } else if (rbuf[0] == 'L' && last_answered != (size_t)-1 && ticks[last_answered].led == 0.0) {
+                ticks[last_answered].led = t;   // LED reflects the newest result
+            }
+            size_t used = (size_t)(nl - rbuf) + 1;
+            memmove(rbuf, nl + 1, rlen - used);
+            rlen -= used;
+        }
+        if (rlen == sizeof(rbuf) - 1) rlen = 0; // Garbage without newline
+    }
+    double elapsed = now_us() - start;
+    close(fd);
+
+    double *res = malloc(total * sizeof(double));
+    double *led = malloc(total * sizeof(double));
+    size_t nres = 0, nled = 0;
+    for (size_t i = 0; i < total; i++) {
+        if (ticks[i].result > 0.0) res[nres++] = ticks[i].result - ticks[i].sent;
+        if (ticks[i].led > 0.0) led[nled++] = ticks[i].led - ticks[i].sent;
+    }
+
+    printf("ticks            %zu sent, %zu answered, %zu errors\n", next_send, nres, errors);
+    printf("throughput       %.1f ticks/s over %.3f s (window %zu)\n",
+           nres / (elapsed / 1e6), elapsed / 1e6, window);
+    report("quote->result", res, nres);
+    report("quote->led", led, nled);
+
+    free(res);
+    free(led);
+    free(ticks);
+    return nres == total ? 0 : 1;
+}
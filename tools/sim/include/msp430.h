@@ -0,0 +1,25 @@
+/**
+ * @file
+ * @brief Host stand-in for <msp430.h>.
+ *
+ * Only the hardware-independent controller modules are built on the host
+ * (pricing, parameters, formatting, the UART protocol, the LED bar
+ * percentage path); this provides the intrinsics their headers touch.
+ * Peripheral I/O is implemented by the simulator itself.
+ */
+#ifndef SIM_MSP430_H
+#define SIM_MSP430_H
+
+#include <stdint.h>
+
+#define __interrupt
+#define __delay_cycles(x)         ((void)0)
+#define _delay_cycles(x)          ((void)0)
+#define __disable_interrupt()     ((void)0)
+#define __enable_interrupt()      ((void)0)
+#define __get_interrupt_state()   ((unsigned short)0)
+#define __set_interrupt_state(x)  ((void)(x))
+
+extern volatile uint16_t TB3R;
+
+#endif // SIM_MSP430_H
@@ -0,0 +1,362 @@
+/**
+ * @file
+ * @brief Simulated controller behind a pseudo-terminal.
+ *
+ * Links the controller's own cmd.c, pricer.c, black_scholes.c, params.c,
+ * fmt.c, chain.c, ledbar_ctl.c and i2c_bus.c against a host HAL, and runs
+ * them the way the firmware's result screen does: poll the UART protocol,
+ * then push the deviation to the LED bar with set_ledbar_percent().
+ *
+ * The UART is a pty paced at the configured baud rate. Bytes the host
+ * writes are timestamped as they reach the pty and land one byte time
+ * apart, into a ring of the firmware's UART_RX_SIZE. A byte that lands on
+ * a full ring is dropped, and UART_RX_GAP is queued in its place, as
+ * uart.c does. Each overrun is reported on stderr.
+ *
+ * The result screen is charged in host time. Entering it draws the LCD
+ * (a clear and two full rows). Each pass of the loop scans the keypad.
+ * Both serve the UART every millisecond, as lcd.c and keypad.c do.
+ *
+ * The LED bar slave
+ * is modelled below the I2C master's single-transfer calls, so the
+ * firmware's retry and recovery policy runs as-is. A transfer lands after
+ * the bus transfer time; the first one carrying a new result is reported
+ * on the serial stream as "L <mask>" so a host can measure quote-to-LED
+ * latency.
+ *
+ * Faults are injected per transfer, each with its own percentage:
+ *   nack     the slave does not acknowledge its address
+ *   al       arbitration is lost partway through the byte
+ *   timeout  the slave stretches SCL past I2C_TIMEOUT_US
+ *   stuck    the slave is left holding SDA low until the bus is recovered;
+ *            transfers time out meanwhile
+ * The F command reports what the retry layer made of them.
+ *
+ * Usage: sim_controller [-b baud] [-l link] [-f fault=pct,...] [-s seed]
+ *   -l creates a symlink to the pty slave (e.g. /tmp/bs-sim).
+ *   -f e.g. "nack=5,timeout=1,stuck=1".
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "uart.h"
+#include "cmd.h"
+#include "pricer.h"
+#include "ledbar_ctl.h"
+#include "i2c_master.h"
+#include "i2c_bus.h"
+#include "persist.h"
+
+#define SIM_WIRE_SIZE 4096                  // Host bytes not yet landed in the RX ring
+#define KEYPAD_SCAN_MS 16                   // pressed_key(): 1 ms per row and column
+#define LCD_PULSE_NS  4000000UL             // lcd_raw_send(): two nibbles, 2 x 1 ms E pulse each
+#define LCD_WAIT_MS   50                    // lcd_raw_send()'s wait after each byte
+#define LCD_CLEAR_MS  200                   // lcd_clear()'s extra wait
+#define LCD_COLS      16
+#define I2C_BYTE_NS   (9UL * 1000000000UL / I2C_BUS_HZ)         // 8 bits + ACK
+#define I2C_WRITE_NS  (2UL * I2C_BYTE_NS)                         // Address + data byte
+
+volatile uint16_t TB3R;
+volatile uint16_t uptime_s;                 // Heartbeat seconds, from the host clock
+volatile int i2c_busy = 0;
+
+// Host memory has no FRAM write protection to lift
+uint16_t fram_unlock(void) { return 0; }
+void fram_lock(uint16_t cfg) { (void)cfg; }
+
+static int pty_fd = -1;
+static unsigned long byte_ns = 0;           // Wire time per UART byte
+static uint8_t rx_buf[UART_RX_SIZE];
+static unsigned rx_head = 0;
+static unsigned rx_tail = 0;
+static int rx_dropped = 0;                  // A gap is waiting to be queued
+static unsigned long rx_drop_bytes = 0;     // In the current overrun
+
+// Bytes on their way in, each with the time its stop bit lands
+static uint8_t wire_buf[SIM_WIRE_SIZE];
+static uint64_t wire_due[SIM_WIRE_SIZE];
+static size_t wire_head = 0;
+static size_t wire_tail = 0;
+static uint64_t wire_last_due = 0;
+static int led_new_result = 0;
+
+enum { FAULT_NACK, FAULT_AL, FAULT_TIMEOUT, FAULT_STUCK, FAULT_KINDS };
+static char *const fault_names[] = {"nack", "al", "timeout", "stuck", NULL};
+static unsigned fault_pct[FAULT_KINDS];
+static int sda_stuck = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static size_t wire_room(void) {
+    return (wire_tail + SIM_WIRE_SIZE - wire_head - 1) % SIM_WIRE_SIZE;
+}
+
+// Move what the host has written onto the wire, one byte time apart
+static void read_pty(void) {
+    uint8_t tmp[256];
+    size_t room = wire_room();
+    struct pollfd pfd = {pty_fd, POLLIN, 0};
+    ssize_t n, i;
+
+    if (room == 0 || poll(&pfd, 1, 0) <= 0) return;
+    n = read(pty_fd, tmp, room < sizeof(tmp) ? room : sizeof(tmp));
+    uint64_t now = now_ns();
+    for (i = 0; i < n; i++) {
+        wire_last_due = (wire_last_due > now ? wire_last_due : now) + byte_ns;
+        wire_buf[wire_head] = tmp[i];
+        wire_due[wire_head] = wire_last_due;
+        wire_head = (wire_head + 1) % SIM_WIRE_SIZE;
+    }
+}
+
+// Wait, still timestamping host bytes as they come in
+static void sleep_ns(unsigned long ns) {
+    uint64_t end = now_ns() + ns, now;
+    struct pollfd pfd = {pty_fd, POLLIN, 0};
+
+    while ((now = now_ns()) < end) {
+        struct timespec ts = {(time_t)((end - now) / 1000000000ULL),
+                              (long)((end - now) % 1000000000ULL)};
+        if (wire_room() == 0) {
+            nanosleep(&ts, NULL);           // Wire full: the host's writes back up
+        } else if (ppoll(&pfd, 1, &ts, NULL) > 0) {
+            read_pty();
+        }
+    }
+}
+
+static void pty_send(const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len) {
+        ssize_t n = write(pty_fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+// --- UART HAL (controller/src/uart.h) ---
+
+void uart_putc(uint8_t c) {
+    sleep_ns(byte_ns);
+    pty_send(&c, 1);
+}
+
+void uart_write(const char *buf, uint16_t len) {
+    sleep_ns(byte_ns * len);
+    pty_send(buf, len);
+}
+
+void uart_puts(const char *str) {
+    uart_write(str, (uint16_t)strlen(str));
+}
+
+static int rx_put(uint8_t c) {
+    unsigned next = (rx_head + 1) & (UART_RX_SIZE - 1);
+    if (next == rx_tail) return 0;
+    rx_buf[rx_head] = c;
+    rx_head = next;
+    return 1;
+}
+
+// The RX ISR, for one landed byte
+static void rx_isr(uint8_t c) {
+    if (rx_dropped) {
+        if (!rx_put(UART_RX_GAP)) {
+            rx_drop_bytes++;
+            return;
+        }
+        rx_dropped = 0;
+        fprintf(stderr, "sim: RX overrun, %lu bytes dropped\n", rx_drop_bytes);
+        rx_drop_bytes = 0;
+    }
+    if (!rx_put(c)) {
+        rx_dropped = 1;
+        rx_drop_bytes++;
+    }
+}
+
+int uart_getc(void) {
+    uint64_t now;
+
+    read_pty();
+    now = now_ns();
+    while (wire_tail != wire_head && wire_due[wire_tail] <= now) {
+        rx_isr(wire_buf[wire_tail]);
+        wire_tail = (wire_tail + 1) % SIM_WIRE_SIZE;
+    }
+    if (rx_tail == rx_head) return -1;
+    uint8_t c = rx_buf[rx_tail];
+    rx_tail = (rx_tail + 1) & (UART_RX_SIZE - 1);
+    return c;
+}
+
+// --- Trace (nothing to dump on the host) ---
+
+void trace_dump(void) {
+    uart_write("TRC", 3);
+    uart_write("C\0\0\0\0\0", 7);           // Board C, 0 Hz, depth 0
+}
+
+// --- I2C master HAL, with the LED bar slave on the other end ---
+
+static int fault(int kind) {
+    return fault_pct[kind] && (unsigned)(rand() % 100) < fault_pct[kind];
+}
+
+uint8_t i2c_xfer_write(uint8_t addr, uint8_t byte) {
+    if (sda_stuck || fault(FAULT_TIMEOUT)) {
+        sleep_ns(I2C_TIMEOUT_US * 1000UL);
+        return I2C_TIMEOUT;
+    }
+    if (addr != I2C_LEDBAR_ADDR || fault(FAULT_NACK)) {
+        sleep_ns(I2C_BYTE_NS);
+        return I2C_NACK;
+    }
+    if (fault(FAULT_AL)) {
+        sleep_ns(I2C_BYTE_NS + I2C_BYTE_NS / 2);
+        return I2C_ARB_LOST;
+    }
+    if (fault(FAULT_STUCK)) {
+        sda_stuck = 1;
+        sleep_ns(I2C_TIMEOUT_US * 1000UL);
+        return I2C_TIMEOUT;
+    }
+
+    sleep_ns(I2C_WRITE_NS);
+    if (led_new_result) {
+        char line[16];
+        int n = snprintf(line, sizeof(line), "L %02X\n", byte);
+        uart_write(line, (uint16_t)n);
+        led_new_result = 0;
+    }
+    return I2C_OK;
+}
+
+uint8_t i2c_sda_low(void) {
+    return (uint8_t)sda_stuck;
+}
+
+uint8_t i2c_bus_recover(void) {
+    sleep_ns(10UL * 1000000000UL / I2C_BUS_HZ);          // 9 SCL pulses + STOP
+    sda_stuck = 0;
+    return 1;
+}
+
+// Parse "-f nack=5,timeout=1"; 0 on error
+static int parse_faults(char *opts) {
+    char *value;
+    while (*opts) {
+        int kind = getsubopt(&opts, fault_names, &value);
+        if (kind < 0 || !value) return 0;
+        unsigned long pct = strtoul(value, NULL, 10);
+        if (pct > 100) return 0;
+        fault_pct[kind] = (unsigned)pct;
+    }
+    return 1;
+}
+
+// ms 1 ms waits, each followed by cmd_poll(), as lcd.c and keypad.c wait
+static void serve_ms(unsigned ms) {
+    while (ms--) {
+        sleep_ns(1000000UL);
+        cmd_poll();
+    }
+}
+
+// lcd_raw_send() of one byte
+static void lcd_send(void) {
+    sleep_ns(LCD_PULSE_NS);
+    serve_ms(LCD_WAIT_MS);
+}
+
+// display_result(): a clear, then each row from its first column
+static void lcd_draw_result(void) {
+    int row, col;
+
+    lcd_send();
+    serve_ms(LCD_CLEAR_MS);
+    for (row = 0; row < 2; row++) {
+        lcd_send();
+        for (col = 0; col < LCD_COLS; col++) lcd_send();
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned long baud = UART_BAUD;
+    const char *link_path = NULL;
+    unsigned seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:l:f:s:")) != -1) {
+        switch (opt) {
+            case 'b': baud = strtoul(optarg, NULL, 10); break;
+            case 'l': link_path = optarg; break;
+            case 'f':
+                if (parse_faults(optarg)) break;
+                fprintf(stderr, "%s: bad fault list '%s'\n", argv[0], optarg);
+                return 2;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-b baud] [-l link] [-f fault=pct,...] [-s seed]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    srand(seed);
+    byte_ns = baud ? 10UL * 1000000000UL / baud : 0;   // 8N1
+
+    pty_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_fd < 0 || grantpt(pty_fd) || unlockpt(pty_fd)) {
+        perror("posix_openpt");
+        return 1;
+    }
+    const char *slave = ptsname(pty_fd);
+
+    // Keep a slave fd open so the master survives clients reconnecting
+    int hold = open(slave, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    tcgetattr(hold, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(hold, TCSANOW, &tio);
+
+    if (link_path) {
+        unlink(link_path);
+        if (symlink(slave, link_path)) perror(link_path);
+    }
+    printf("%s\n", slave);
+    fflush(stdout);
+
+    float prev_pct = 0.0f;
+    time_t start = time(NULL);
+    lcd_draw_result();
+    for (;;) {
+        uptime_s = (uint16_t)(time(NULL) - start);
+        serve_ms(KEYPAD_SCAN_MS);           // pressed_key() with nothing pressed
+        cmd_poll();
+
+        // Result-screen loop from main.c: LED bar tracks the latest result
+        float pct = last_result.pct_diff;
+        if (memcmp(&pct, &prev_pct, sizeof(pct)) != 0) {
+            led_new_result = 1;
+            prev_pct = pct;
+        }
+        set_ledbar_percent(pct);
+    }
+    close(hold);
+    return 0;
+}
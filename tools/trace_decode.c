@@ -0,0 +1,387 @@
+/**
+ * @file
+ * @brief Decode trace dumps from the controller and LED bar.
+ *
+ * Reads one or more "TRC" frames (as captured from the UART, other bytes
+ * in between are skipped), rebuilds absolute timestamps from the WRAP
+ * records, and prints a timeline plus latency histograms. Optionally
+ * writes Chrome trace JSON (chrome://tracing, Perfetto).
+ *
+ * Usage: trace_decode [-q] [-c out.json] [dump.bin ...]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Must match controller/src/trace.h and i2c-led-bar/src/trace.h
+#define TRACE_EV_NONE        0
+#define TRACE_EV_WRAP        1
+#define TRACE_EV_KEY         2
+#define TRACE_EV_ENC         3
+#define TRACE_EV_PRICE_START 4
+#define TRACE_EV_PRICE_END   5
+#define TRACE_EV_I2C_START   6
+#define TRACE_EV_I2C_STOP    7
+#define TRACE_EV_I2C_NACK    8
+#define TRACE_EV_LCD_FLUSH   9
+#define TRACE_EV_I2C_RX      10
+#define TRACE_EV_LED_UPDATE  11
+#define TRACE_EV_I2C_ERR     12
+#define TRACE_EV_I2C_RECOVER 13
+#define TRACE_EV_SNAP_START  14
+#define TRACE_EV_SNAP_END    15
+#define TRACE_EV_COUNT       16
+
+static const char *const ev_names[TRACE_EV_COUNT] = {
+    "none", "wrap", "key", "enc", "price_start", "price_end",
+    "i2c_start", "i2c_stop", "i2c_nack", "lcd_flush", "i2c_rx", "led_update",
+    "i2c_err", "i2c_recover", "snap_start", "snap_end",
+};
+
+struct event {
+    double us;          // Microseconds since the first record of the frame
+    uint8_t id;
+    uint8_t arg;
+};
+
+struct frame {
+    char board;
+    uint32_t hz;
+    struct event *ev;
+    size_t n;
+};
+
+// Spans measured between a start event and the next matching end event
+struct span_kind {
+    const char *name;
+    uint8_t start;
+    uint8_t end;
+};
+
+static const struct span_kind spans[] = {
+    {"pricing",           TRACE_EV_PRICE_START, TRACE_EV_PRICE_END},
+    {"i2c transaction",   TRACE_EV_I2C_START,   TRACE_EV_I2C_STOP},
+    {"key to lcd flush",  TRACE_EV_KEY,         TRACE_EV_LCD_FLUSH},
+    {"i2c rx to led",     TRACE_EV_I2C_RX,      TRACE_EV_LED_UPDATE},
+    {"param snapshot",    TRACE_EV_SNAP_START,  TRACE_EV_SNAP_END},
+};
+#define NUM_SPANS (sizeof(spans) / sizeof(spans[0]))
+
+#define HIST_BUCKETS 32     // log2(us) buckets
+
+struct hist {
+    unsigned long count;
+    double min;
+    double max;
+    double sum;
+    unsigned long bucket[HIST_BUCKETS];
+};
+
+static uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * Work out which timer epoch (number of 16-bit wraps) each record is in.
+ *
+ * The firmware logs WRAP(c) at an overflow only if something was traced
+ * during the epoch that just ended, so records before WRAP(c) belong to
+ * epoch c - 1. A record read just after an overflow can land before the
+ * WRAP record; its timestamp is then below the WRAP's and it goes to
+ * epoch c. After the last WRAP, and in dumps without any, a timestamp
+ * going backwards starts a new epoch.
+ */
+static void assign_epochs(const uint8_t *rec, size_t n, long *epoch) {
+    long next_wrap = -1;
+    uint16_t next_wrap_ts = 0;
+    size_t i;
+
+    // Unwrap the 8-bit wrap counters front to back
+    long *unwrapped = calloc(n, sizeof(long));
+    long last = -1;
+    for (i = 0; i < n; i++) {
+        if (rec[i * 4 + 2] != TRACE_EV_WRAP) continue;
+        uint8_t c = rec[i * 4 + 3];
+        if (last < 0) {
+            last = c;
+        } else {
+            uint8_t d = (uint8_t)(c - (uint8_t)last);
+            last += d ? d : 256;
+        }
+        unwrapped[i] = last;
+    }
+
+    // Back to front: each record takes the epoch implied by the next WRAP
+    for (i = n; i-- > 0;) {
+        uint8_t id = rec[i * 4 + 2];
+        uint16_t ts = rd16(&rec[i * 4]);
+        if (id == TRACE_EV_WRAP) {
+            next_wrap = unwrapped[i];
+            next_wrap_ts = ts;
+            epoch[i] = next_wrap;
+        } else if (next_wrap >= 0) {
+            epoch[i] = (ts <= next_wrap_ts) ? next_wrap : next_wrap - 1;
+        } else {
+            epoch[i] = -1;          // After the last WRAP, resolved below
+        }
+    }
+
+    // Tail: continue from the last known epoch, bumping on backwards time
+    long e = last >= 0 ? last : 0;
+    uint16_t prev_ts = 0;
+    int have_prev = 0;
+    for (i = 0; i < n; i++) {
+        uint16_t ts = rd16(&rec[i * 4]);
+        if (epoch[i] >= 0) {
+            e = epoch[i];
+        } else {
+            if (have_prev && ts < prev_ts) e++;
+            epoch[i] = e;
+        }
+        prev_ts = ts;
+        have_prev = 1;
+    }
+    free(unwrapped);
+}
+
+/**
+ * Parse one frame starting at "TRC".
+ *
+ * @return: Bytes consumed, or 0 if the frame is truncated.
+ */
+static size_t parse_frame(const uint8_t *p, size_t avail, struct frame *f) {
+    if (avail < 10) return 0;
+    uint16_t depth = rd16(&p[8]);
+    size_t len = 10 + (size_t)depth * 4;
+    if (avail < len) return 0;
+
+    f->board = (char)p[3];
+    f->hz = rd16(&p[4]) | ((uint32_t)rd16(&p[6]) << 16);
+    f->ev = calloc(depth, sizeof(struct event));
+    f->n = 0;
+
+    const uint8_t *rec = &p[10];
+    long *epoch = calloc(depth ? depth : 1, sizeof(long));
+
+    // Drop empty slots first so epochs only see real records
+    uint8_t *packed = malloc(depth ? (size_t)depth * 4 : 1);
+    size_t m = 0;
+    for (size_t i = 0; i < depth; i++) {
+        if (rec[i * 4 + 2] == TRACE_EV_NONE) continue;
+        memcpy(&packed[m * 4], &rec[i * 4], 4);
+        m++;
+    }
+    assign_epochs(packed, m, epoch);
+
+    double t0 = 0.0;
+    for (size_t i = 0; i < m; i++) {
+        double ticks = (double)epoch[i] * 65536.0 + rd16(&packed[i * 4]);
+        double us = ticks * 1e6 / (f->hz ? f->hz : 1);
+        if (i == 0) t0 = us;
+        f->ev[f->n].us = us - t0;
+        f->ev[f->n].id = packed[i * 4 + 2];
+        f->ev[f->n].arg = packed[i * 4 + 3];
+        f->n++;
+    }
+    free(packed);
+    free(epoch);
+    return len;
+}
+
+static void hist_add(struct hist *h, double us) {
+    int b = 0;
+    double v = us;
+    while (v >= 2.0 && b < HIST_BUCKETS - 1) {
+        v /= 2.0;
+        b++;
+    }
+    if (h->count == 0 || us < h->min) h->min = us;
+    if (h->count == 0 || us > h->max) h->max = us;
+    h->sum += us;
+    h->count++;
+    h->bucket[b]++;
+}
+
+static void hist_print(const char *name, const struct hist *h) {
+    unsigned long peak = 0;
+    int b;
+    if (h->count == 0) return;
+    printf("\n%s: n=%lu min=%.1f us avg=%.1f us max=%.1f us\n",
+           name, h->count, h->min, h->sum / h->count, h->max);
+    for (b = 0; b < HIST_BUCKETS; b++) {
+        if (h->bucket[b] > peak) peak = h->bucket[b];
+    }
+    for (b = 0; b < HIST_BUCKETS; b++) {
+        if (!h->bucket[b]) continue;
+        int bar = (int)(h->bucket[b] * 40 / peak);
+        printf("  %10.0f - %-10.0f us %6lu |", b ? (double)(1UL << b) : 0.0, (double)(2UL << b), h->bucket[b]);
+        while (bar--) putchar('#');
+        putchar('\n');
+    }
+}
+
+static void print_arg(uint8_t id, uint8_t arg) {
+    switch (id) {
+        case TRACE_EV_KEY:       printf(" '%c'", arg); break;
+        case TRACE_EV_ENC:       printf(" %+d", (int8_t)arg); break;
+        case TRACE_EV_I2C_START:
+        case TRACE_EV_I2C_RX:
+        case TRACE_EV_LED_UPDATE: printf(" 0x%02X", arg); break;
+        case TRACE_EV_LCD_FLUSH: printf(" %u chars", arg); break;
+        case TRACE_EV_WRAP:      printf(" #%u", arg); break;
+        case TRACE_EV_I2C_ERR:
+            printf(" %s", arg == 1 ? "nack" : arg == 2 ? "arb_lost" : arg == 3 ? "timeout" : "?");
+            break;
+        case TRACE_EV_I2C_RECOVER: printf(" %s", arg ? "released" : "stuck"); break;
+        case TRACE_EV_SNAP_END:  printf(" %u retries", arg); break;
+        default: break;
+    }
+}
+
+static void chrome_frame(FILE *out, const struct frame *f, int *first) {
+    int pid = (unsigned char)f->board;
+    for (size_t i = 0; i < f->n; i++) {
+        const struct event *e = &f->ev[i];
+        if (e->id == TRACE_EV_WRAP) continue;
+
+        size_t s;
+        int is_span = 0;
+        for (s = 0; s < NUM_SPANS; s++) {
+            if (spans[s].start != e->id) continue;
+            for (size_t j = i + 1; j < f->n; j++) {
+                if (f->ev[j].id == spans[s].end) {
+                    fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                            *first ? "" : ",", spans[s].name, pid, (int)s + 1, e->us, f->ev[j].us - e->us);
+                    *first = 0;
+                    is_span = 1;
+                    break;
+                }
+                if (f->ev[j].id == spans[s].start) break;
+            }
+        }
+        if (!is_span) {
+            fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"args\":{\"arg\":%u}}",
+                    *first ? "" : ",", e->id < TRACE_EV_COUNT ? ev_names[e->id] : "unknown", pid, e->us, e->arg);
+            *first = 0;
+        }
+    }
+}
+
+static uint8_t *read_all(FILE *in, size_t *len) {
+    size_t cap = 4096;
+    uint8_t *buf = malloc(cap);
+    size_t n;
+    *len = 0;
+    while ((n = fread(buf + *len, 1, cap - *len, in)) > 0) {
+        *len += n;
+        if (*len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    const char *chrome_path = NULL;
+    int quiet = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "qc:")) != -1) {
+        switch (opt) {
+            case 'q': quiet = 1; break;
+            case 'c': chrome_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-q] [-c out.json] [dump.bin ...]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    FILE *chrome = NULL;
+    int chrome_first = 1;
+    if (chrome_path) {
+        chrome = fopen(chrome_path, "w");
+        if (!chrome) {
+            perror(chrome_path);
+            return 1;
+        }
+        fputs("{\"traceEvents\":[", chrome);
+    }
+
+    struct hist hists[NUM_SPANS];
+    memset(hists, 0, sizeof(hists));
+    int frames = 0;
+    int arg = optind;
+
+    do {
+        FILE *in = stdin;
+        const char *name = "stdin";
+        if (arg < argc) {
+            name = argv[arg];
+            in = fopen(name, "rb");
+            if (!in) {
+                perror(name);
+                return 1;
+            }
+        }
+        size_t len;
+        uint8_t *buf = read_all(in, &len);
+        if (in != stdin) fclose(in);
+
+        size_t pos = 0;
+        while (pos + 3 <= len) {
+            if (memcmp(&buf[pos], "TRC", 3) != 0) {
+                pos++;
+                continue;
+            }
+            struct frame f;
+            size_t used = parse_frame(&buf[pos], len - pos, &f);
+            if (!used) {
+                fprintf(stderr, "%s: truncated frame at offset %zu\n", name, pos);
+                break;
+            }
+            pos += used;
+            frames++;
+
+            if (!quiet) {
+                printf("== board %c, %u Hz timer, %zu records ==\n", f.board, f.hz, f.n);
+                for (size_t i = 0; i < f.n; i++) {
+                    printf("%14.3f us  %-12s", f.ev[i].us,
+                           f.ev[i].id < TRACE_EV_COUNT ? ev_names[f.ev[i].id] : "unknown");
+                    print_arg(f.ev[i].id, f.ev[i].arg);
+                    putchar('\n');
+                }
+            }
+
+            for (size_t s = 0; s < NUM_SPANS; s++) {
+                double start = -1.0;
+                for (size_t i = 0; i < f.n; i++) {
+                    if (f.ev[i].id == spans[s].start) {
+                        start = f.ev[i].us;
+                    } else if (f.ev[i].id == spans[s].end && start >= 0.0) {
+                        hist_add(&hists[s], f.ev[i].us - start);
+                        start = -1.0;
+                    }
+                }
+            }
+            if (chrome) chrome_frame(chrome, &f, &chrome_first);
+            free(f.ev);
+        }
+        free(buf);
+        arg++;
+    } while (arg < argc);
+
+    for (size_t s = 0; s < NUM_SPANS; s++) {
+        hist_print(spans[s].name, &hists[s]);
+    }
+    if (chrome) {
+        fputs("\n]}\n", chrome);
+        fclose(chrome);
+    }
+    if (!frames) {
+        fprintf(stderr, "no trace frames found\n");
+        return 1;
+    }
+    return 0;
+}